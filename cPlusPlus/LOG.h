@@ -1,15 +1,89 @@
 #ifndef LOG_H
 #define LOG_H
 
-/*
-#include "Logger.h"
+#include "Logger3.h"
 
+// 日志宏
+//   1. 编译期裁剪：低于 LOGSYS_MIN_LEVEL 的宏展开为空语句，参数不会出现在目标代码中。
+//      编译时用 -DLOGSYS_MIN_LEVEL=2 等指定，数值与 LogLevel_en 一致（1=DEBUG … 5=FATAL）。
+//   2. 运行时过滤：先做一次 relaxed 原子读判断等级，未启用时不求值参数、不进入变参调用。
+//      调用点设置了等级覆盖（LogCallSiteRegistry::setLevelOverride）时以覆盖为准。
+// 宏名使用 LOGSYS_ 前缀，因为 LOG_DEBUG、LOG_INFO 等已由 <syslog.h> 定义为优先级常量。
 
-#define LOG_INIT(path, name, maxFileSize, maxFileCount) \
+#ifndef LOGSYS_MIN_LEVEL
+#define LOGSYS_MIN_LEVEL 1
+#endif
+
+// 默认日志实例：首次调用后缓存引用，之后每次只是一次静态变量读取
+inline Logger& logsysDefaultLogger() {
+    static Logger& logger = Logger::getInstance();
+    return logger;
+}
+
+#define LOGSYS_INIT(path, name, maxFileSize, maxFileCount) \
     Logger::getInstance(path, name, maxFileSize, maxFileCount)
 
-#define LOG(level, format, ...) \
-    Logger::getInstance().log(level, format, __FILE__, __LINE__, ##__VA_ARGS__)
-*/
+// 写入指定实例。每个调用点首次执行时登记一次（文件、行号、函数、等级、格式串），
+// 之后经静态引用直接取用；level 与 format 在同一调用点应保持不变
+#define LOGSYS_LOG_TO(logger, level, format, ...)                                  \
+    do {                                                                           \
+        static const LogCallSite& logsysSite_ = LogCallSiteRegistry::instance().registerSite( \
+            __FILE__, __LINE__, __func__, level, format);                          \
+        Logger& logsysLogger_ = (logger);                                          \
+        if (logsysLogger_.isEnabled(logsysSite_))                                  \
+            logsysLogger_.log(&logsysSite_, ##__VA_ARGS__);                        \
+    } while (0)
+
+// 写入默认实例
+#define LOGSYS_LOG(level, format, ...) \
+    LOGSYS_LOG_TO(logsysDefaultLogger(), level, format, ##__VA_ARGS__)
+
+// 按类别写入指定实例：category 为 Logger::category 返回的句柄，等级判断只读句柄上缓存的生效等级。
+// 不做编译期裁剪，LOGSYS_MIN_LEVEL 只作用于下面按等级命名的宏
+#define LOGSYS_CLOG_TO(logger, category, level, format, ...)                       \
+    do {                                                                           \
+        static const LogCallSite& logsysSite_ = LogCallSiteRegistry::instance().registerSite( \
+            __FILE__, __LINE__, __func__, level, format);                          \
+        Logger& logsysLogger_ = (logger);                                          \
+        const LogCategory& logsysCategory_ = (category);                           \
+        if (logsysLogger_.isEnabled(logsysSite_, logsysCategory_))                 \
+            logsysLogger_.log(logsysCategory_, &logsysSite_, ##__VA_ARGS__);       \
+    } while (0)
+
+// 按类别写入默认实例
+#define LOGSYS_CLOG(category, level, format, ...) \
+    LOGSYS_CLOG_TO(logsysDefaultLogger(), category, level, format, ##__VA_ARGS__)
+
+#define LOGSYS_DISCARD(format, ...) do { } while (0)
+
+#if LOGSYS_MIN_LEVEL <= 1
+#define LOGSYS_DEBUG(format, ...) LOGSYS_LOG(DEBUG, format, ##__VA_ARGS__)
+#else
+#define LOGSYS_DEBUG(format, ...) LOGSYS_DISCARD(format, ##__VA_ARGS__)
+#endif
+
+#if LOGSYS_MIN_LEVEL <= 2
+#define LOGSYS_INFO(format, ...) LOGSYS_LOG(INFO, format, ##__VA_ARGS__)
+#else
+#define LOGSYS_INFO(format, ...) LOGSYS_DISCARD(format, ##__VA_ARGS__)
+#endif
+
+#if LOGSYS_MIN_LEVEL <= 3
+#define LOGSYS_WARNING(format, ...) LOGSYS_LOG(WARNING, format, ##__VA_ARGS__)
+#else
+#define LOGSYS_WARNING(format, ...) LOGSYS_DISCARD(format, ##__VA_ARGS__)
+#endif
+
+#if LOGSYS_MIN_LEVEL <= 4
+#define LOGSYS_ERROR(format, ...) LOGSYS_LOG(ERROR, format, ##__VA_ARGS__)
+#else
+#define LOGSYS_ERROR(format, ...) LOGSYS_DISCARD(format, ##__VA_ARGS__)
+#endif
+
+#if LOGSYS_MIN_LEVEL <= 5
+#define LOGSYS_FATAL(format, ...) LOGSYS_LOG(FATAL, format, ##__VA_ARGS__)
+#else
+#define LOGSYS_FATAL(format, ...) LOGSYS_DISCARD(format, ##__VA_ARGS__)
+#endif
 
-#endif // LOG_H
\ No newline at end of file
+#endif // LOG_H
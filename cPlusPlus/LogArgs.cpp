@@ -0,0 +1,314 @@
+#include "LogArgs.h"
+#include <cstdio>
+#include <cstddef>
+#include <cstdlib>
+#include <sys/types.h>
+
+namespace {
+
+// 一个 printf 转换说明的解析结果
+struct ConversionSpec {
+    const char* end = nullptr;             // 转换字符之后的位置
+    const char* flags = nullptr;           // '%' 之后的标志、宽度、精度部分
+    size_t flagsLen = 0;                   // 该部分的长度
+    bool widthStar = false;                // 宽度由参数给出
+    bool precisionStar = false;            // 精度由参数给出
+    int precision = -1;                    // 字面精度，未指定时为 -1
+    char length[3] = {0};                  // 长度修饰符（h、hh、l、ll、j、z、t、L、q）
+    char conv = 0;                         // 转换字符
+};
+
+// 解析 p（指向 '%'）开始的转换说明；不支持位置参数等写法时返回 false
+bool parseSpec(const char* p, ConversionSpec& spec) {
+    const char* q = p + 1;
+    spec.flags = q;
+    while (*q && strchr("-+ #0'", *q)) ++q;
+    if (*q == '*') {
+        spec.widthStar = true;
+        ++q;
+    } else {
+        while (*q >= '0' && *q <= '9') ++q;
+    }
+    if (*q == '$') return false;
+    if (*q == '.') {
+        ++q;
+        if (*q == '*') {
+            spec.precisionStar = true;
+            ++q;
+        } else {
+            spec.precision = 0;
+            while (*q >= '0' && *q <= '9') spec.precision = spec.precision * 10 + (*q++ - '0');
+        }
+    }
+    spec.flagsLen = q - spec.flags;
+
+    size_t n = 0;
+    while (*q && strchr("hljztLq", *q) && n < 2) spec.length[n++] = *q++;
+    if (!*q) return false;
+    spec.conv = *q;
+    spec.end = q + 1;
+    return true;
+}
+
+bool isLength(const ConversionSpec& spec, const char* length) {
+    return strcmp(spec.length, length) == 0;
+}
+
+// 按长度修饰符取出有符号整数
+int64_t readSignedArg(const ConversionSpec& spec, va_list& args) {
+    if (isLength(spec, "hh")) return static_cast<signed char>(va_arg(args, int));
+    if (isLength(spec, "h")) return static_cast<short>(va_arg(args, int));
+    if (isLength(spec, "l")) return va_arg(args, long);
+    if (isLength(spec, "ll") || isLength(spec, "q")) return va_arg(args, long long);
+    if (isLength(spec, "j")) return va_arg(args, intmax_t);
+    if (isLength(spec, "z")) return va_arg(args, ssize_t);
+    if (isLength(spec, "t")) return va_arg(args, ptrdiff_t);
+    return va_arg(args, int);
+}
+
+// 按长度修饰符取出无符号整数
+uint64_t readUnsignedArg(const ConversionSpec& spec, va_list& args) {
+    if (isLength(spec, "hh")) return static_cast<unsigned char>(va_arg(args, unsigned int));
+    if (isLength(spec, "h")) return static_cast<unsigned short>(va_arg(args, unsigned int));
+    if (isLength(spec, "l")) return va_arg(args, unsigned long);
+    if (isLength(spec, "ll") || isLength(spec, "q")) return va_arg(args, unsigned long long);
+    if (isLength(spec, "j")) return va_arg(args, uintmax_t);
+    if (isLength(spec, "z")) return va_arg(args, size_t);
+    if (isLength(spec, "t")) return static_cast<uint64_t>(va_arg(args, ptrdiff_t));
+    return va_arg(args, unsigned int);
+}
+
+// 顺序读取打包参数
+class PackedArgReader {
+public:
+    PackedArgReader(const char* data, size_t size) : cur(data), end(data + size) {}
+
+    template <typename T>
+    bool read(PackedArgType type, T& value) {
+        if (end - cur < static_cast<ptrdiff_t>(1 + sizeof(T)) || static_cast<uint8_t>(*cur) != type) return false;
+        memcpy(&value, cur + 1, sizeof(T));
+        cur += 1 + sizeof(T);
+        return true;
+    }
+
+    bool readString(const char*& str, uint32_t& len) {
+        if (end - cur < static_cast<ptrdiff_t>(1 + sizeof(uint32_t)) || static_cast<uint8_t>(*cur) != ARG_STRING) {
+            return false;
+        }
+        memcpy(&len, cur + 1, sizeof(len));
+        if (static_cast<size_t>(end - cur) < 1 + sizeof(len) + len) return false;
+        str = cur + 1 + sizeof(len);
+        cur += 1 + sizeof(len) + len;
+        return true;
+    }
+
+private:
+    const char* cur;
+    const char* end;
+};
+
+template <typename T>
+int callSnprintf(char* buf, size_t size, const char* spec, const int* stars, int starCount, T value) {
+    switch (starCount) {
+        case 0:  return snprintf(buf, size, spec, value);
+        case 1:  return snprintf(buf, size, spec, stars[0], value);
+        default: return snprintf(buf, size, spec, stars[0], stars[1], value);
+    }
+}
+
+// 用单个参数格式化一个转换说明，结果追加到 out
+template <typename T>
+void appendFormatted(std::string& out, const char* spec, const int* stars, int starCount, T value) {
+    char buf[256];
+    int n = callSnprintf(buf, sizeof(buf), spec, stars, starCount, value);
+    if (n < 0) return;
+    if (static_cast<size_t>(n) < sizeof(buf)) {
+        out.append(buf, n);
+        return;
+    }
+    size_t old = out.size();
+    out.resize(old + n + 1);
+    callSnprintf(&out[old], n + 1, spec, stars, starCount, value);
+    out.resize(old + n);
+}
+
+// 逐个转换说明取出参数并打包
+bool packArgs(const char* format, va_list& args, std::string& out) {
+    for (const char* p = format; *p;) {
+        if (*p != '%') {
+            ++p;
+            continue;
+        }
+        if (p[1] == '%') {
+            p += 2;
+            continue;
+        }
+
+        ConversionSpec spec;
+        if (!parseSpec(p, spec)) return false;
+
+        int precision = spec.precision;
+        if (spec.widthStar) {
+            appendPackedValue<int64_t>(out, ARG_SIGNED, va_arg(args, int));
+        }
+        if (spec.precisionStar) {
+            precision = va_arg(args, int);
+            appendPackedValue<int64_t>(out, ARG_SIGNED, precision);
+        }
+
+        switch (spec.conv) {
+            case 'd': case 'i':
+                appendPackedValue(out, ARG_SIGNED, readSignedArg(spec, args));
+                break;
+            case 'o': case 'u': case 'x': case 'X':
+                appendPackedValue(out, ARG_UNSIGNED, readUnsignedArg(spec, args));
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                if (isLength(spec, "L")) {
+                    appendPackedValue(out, ARG_LONG_DOUBLE, va_arg(args, long double));
+                } else {
+                    appendPackedValue(out, ARG_DOUBLE, va_arg(args, double));
+                }
+                break;
+            case 'c':
+                if (spec.length[0]) return false; // 宽字符
+                appendPackedValue<int32_t>(out, ARG_CHAR, va_arg(args, int));
+                break;
+            case 's': {
+                if (spec.length[0]) return false; // 宽字符串
+                const char* str = va_arg(args, const char*);
+                if (!str) str = "(null)";
+                size_t len = precision >= 0 ? strnlen(str, precision) : strlen(str);
+                appendPackedString(out, str, len);
+                break;
+            }
+            case 'p':
+                appendPackedValue<uint64_t>(out, ARG_POINTER, reinterpret_cast<uintptr_t>(va_arg(args, void*)));
+                break;
+            default: // %n、%m 及未知转换
+                return false;
+        }
+        p = spec.end;
+    }
+    return true;
+}
+
+} // namespace
+
+// va_list 在部分平台上是数组类型，拷贝一份以便按引用传给辅助函数
+bool packPrintfArgs(const char* format, va_list args, std::string& out) {
+    va_list ap;
+    va_copy(ap, args);
+    bool ok = packArgs(format, ap, out);
+    va_end(ap);
+    return ok;
+}
+
+void formatPackedArgs(const char* format, const char* data, size_t size, std::string& out) {
+    PackedArgReader reader(data, size);
+    std::string str;
+    char spec[64];
+
+    const char* p = format;
+    while (*p) {
+        const char* percent = strchr(p, '%');
+        if (!percent) {
+            out.append(p);
+            return;
+        }
+        out.append(p, percent - p);
+        if (percent[1] == '%') {
+            out.push_back('%');
+            p = percent + 2;
+            continue;
+        }
+
+        ConversionSpec conv;
+        if (!parseSpec(percent, conv) || conv.flagsLen > sizeof(spec) - 8) {
+            out.append(percent);
+            return;
+        }
+
+        int stars[2];
+        int starCount = 0;
+        int64_t star;
+        if (conv.widthStar) {
+            if (!reader.read(ARG_SIGNED, star)) return;
+            stars[starCount++] = static_cast<int>(star);
+        }
+        if (conv.precisionStar) {
+            if (!reader.read(ARG_SIGNED, star)) return;
+            stars[starCount++] = static_cast<int>(star);
+        }
+
+        // 重建转换说明：整数统一按 ll 格式化，其余保留原长度修饰符
+        char* s = spec;
+        *s++ = '%';
+        memcpy(s, conv.flags, conv.flagsLen);
+        s += conv.flagsLen;
+
+        switch (conv.conv) {
+            case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': {
+                *s++ = 'l';
+                *s++ = 'l';
+                *s++ = conv.conv;
+                *s = '\0';
+                if (conv.conv == 'd' || conv.conv == 'i') {
+                    int64_t value;
+                    if (!reader.read(ARG_SIGNED, value)) return;
+                    appendFormatted(out, spec, stars, starCount, static_cast<long long>(value));
+                } else {
+                    uint64_t value;
+                    if (!reader.read(ARG_UNSIGNED, value)) return;
+                    appendFormatted(out, spec, stars, starCount, static_cast<unsigned long long>(value));
+                }
+                break;
+            }
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+                if (isLength(conv, "L")) *s++ = 'L';
+                *s++ = conv.conv;
+                *s = '\0';
+                if (isLength(conv, "L")) {
+                    long double value;
+                    if (!reader.read(ARG_LONG_DOUBLE, value)) return;
+                    appendFormatted(out, spec, stars, starCount, value);
+                } else {
+                    double value;
+                    if (!reader.read(ARG_DOUBLE, value)) return;
+                    appendFormatted(out, spec, stars, starCount, value);
+                }
+                break;
+            }
+            case 'c': {
+                *s++ = 'c';
+                *s = '\0';
+                int32_t value;
+                if (!reader.read(ARG_CHAR, value)) return;
+                appendFormatted(out, spec, stars, starCount, static_cast<int>(value));
+                break;
+            }
+            case 's': {
+                *s++ = 's';
+                *s = '\0';
+                const char* value;
+                uint32_t len;
+                if (!reader.readString(value, len)) return;
+                str.assign(value, len);
+                appendFormatted(out, spec, stars, starCount, str.c_str());
+                break;
+            }
+            case 'p': {
+                *s++ = 'p';
+                *s = '\0';
+                uint64_t value;
+                if (!reader.read(ARG_POINTER, value)) return;
+                appendFormatted(out, spec, stars, starCount, reinterpret_cast<void*>(static_cast<uintptr_t>(value)));
+                break;
+            }
+            default:
+                out.append(percent);
+                return;
+        }
+        p = conv.end;
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef LOG_ARGS_H
+#define LOG_ARGS_H
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// 延迟格式化使用的二进制参数编码：
+// 每个参数为 1 字节类型标记 + 原始字节，字符串为 4 字节长度 + 内容。
+// 生产线程只按格式串拷贝参数，格式化工作由写线程（或离线解码工具）完成。
+
+// 参数类型标记
+enum PackedArgType : uint8_t {
+    ARG_SIGNED = 1,      // 有符号整数，按 int64 存储
+    ARG_UNSIGNED,        // 无符号整数，按 uint64 存储
+    ARG_DOUBLE,          // double
+    ARG_LONG_DOUBLE,     // long double
+    ARG_CHAR,            // 字符，按 int32 存储
+    ARG_STRING,          // 字符串，uint32 长度 + 内容
+    ARG_POINTER          // 指针，按 uint64 存储
+};
+
+// 追加一个定长参数
+template <typename T>
+inline void appendPackedValue(std::string& out, PackedArgType type, T value) {
+    char bytes[1 + sizeof(T)];
+    bytes[0] = static_cast<char>(type);
+    memcpy(bytes + 1, &value, sizeof(T));
+    out.append(bytes, sizeof(bytes));
+}
+
+// 追加一个字符串参数
+inline void appendPackedString(std::string& out, const char* str, size_t len) {
+    char header[1 + sizeof(uint32_t)];
+    uint32_t len32 = static_cast<uint32_t>(len);
+    header[0] = static_cast<char>(ARG_STRING);
+    memcpy(header + 1, &len32, sizeof(len32));
+    out.append(header, sizeof(header));
+    out.append(str, len);
+}
+
+// 按 printf 格式串从 va_list 中取出参数并打包到 out。
+// 遇到不支持延迟格式化的转换（%n、%m、宽字符等）时返回 false，调用方应改为立即格式化。
+bool packPrintfArgs(const char* format, va_list args, std::string& out);
+
+// 用打包的参数按格式串格式化，结果追加到 out。参数不足或损坏时截止于该处。
+void formatPackedArgs(const char* format, const char* data, size_t size, std::string& out);
+
+#endif // LOG_ARGS_H
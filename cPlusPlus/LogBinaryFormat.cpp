@@ -0,0 +1,299 @@
+#include "LogBinaryFormat.h"
+#include <cstring>
+#include "LogArgs.h"
+
+namespace {
+
+const char kSessionMagic[] = "LOGSYSB1";
+const size_t kSessionMagicLen = sizeof(kSessionMagic) - 1;
+const uint8_t kFormatVersion = 1;
+
+// 记录标记
+enum BinaryTag : uint8_t {
+    TAG_CALL_SITE = 0x01,                  // 调用点定义
+    TAG_RECORD = 0x02,                     // 延迟格式化记录
+    TAG_TEXT = 0x03,                       // 已格式化文本记录
+    TAG_SESSION = 0x7F                     // 会话头
+};
+
+void appendVarint(std::string& out, uint64_t value) {
+    char bytes[10];
+    size_t n = 0;
+    while (value >= 0x80) {
+        bytes[n++] = static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    bytes[n++] = static_cast<char>(value);
+    out.append(bytes, n);
+}
+
+inline uint64_t zigzagEncode(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+bool readVarint(const char*& cur, const char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && cur < end; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(*cur++);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool readBytes(const char*& cur, const char* end, std::string& out) {
+    uint64_t len;
+    if (!readVarint(cur, end, len) || static_cast<uint64_t>(end - cur) < len) return false;
+    out.assign(cur, len);
+    cur += len;
+    return true;
+}
+
+// LogArgs 编码 -> 紧凑编码：整数改为 varint，字符串长度改为 varint，浮点数保持原样
+void compactArgs(std::string& out, const char* cur, size_t size) {
+    const char* end = cur + size;
+    while (cur < end) {
+        uint8_t type = static_cast<uint8_t>(*cur);
+        size_t valueLen = type == ARG_SIGNED || type == ARG_UNSIGNED || type == ARG_POINTER ? 8
+                        : type == ARG_DOUBLE ? sizeof(double)
+                        : type == ARG_LONG_DOUBLE ? sizeof(long double)
+                        : type == ARG_CHAR || type == ARG_STRING ? 4
+                        : 0;
+        if (valueLen == 0 || static_cast<size_t>(end - cur) < 1 + valueLen) return;
+        out.push_back(static_cast<char>(type));
+        const char* value = cur + 1;
+        cur += 1 + valueLen;
+
+        switch (type) {
+            case ARG_SIGNED: {
+                int64_t v;
+                memcpy(&v, value, sizeof(v));
+                appendVarint(out, zigzagEncode(v));
+                break;
+            }
+            case ARG_UNSIGNED:
+            case ARG_POINTER: {
+                uint64_t v;
+                memcpy(&v, value, sizeof(v));
+                appendVarint(out, v);
+                break;
+            }
+            case ARG_CHAR: {
+                int32_t v;
+                memcpy(&v, value, sizeof(v));
+                appendVarint(out, zigzagEncode(v));
+                break;
+            }
+            case ARG_STRING: {
+                uint32_t len;
+                memcpy(&len, value, sizeof(len));
+                if (static_cast<size_t>(end - cur) < len) return;
+                appendVarint(out, len);
+                out.append(cur, len);
+                cur += len;
+                break;
+            }
+            default:
+                out.append(value, valueLen);
+                break;
+        }
+    }
+}
+
+// 紧凑编码 -> LogArgs 编码，供 formatPackedArgs 使用
+bool expandArgs(const char* cur, const char* end, std::string& out) {
+    while (cur < end) {
+        uint8_t type = static_cast<uint8_t>(*cur++);
+        uint64_t v;
+        switch (type) {
+            case ARG_SIGNED:
+                if (!readVarint(cur, end, v)) return false;
+                appendPackedValue<int64_t>(out, ARG_SIGNED, zigzagDecode(v));
+                break;
+            case ARG_UNSIGNED:
+            case ARG_POINTER:
+                if (!readVarint(cur, end, v)) return false;
+                appendPackedValue<uint64_t>(out, static_cast<PackedArgType>(type), v);
+                break;
+            case ARG_CHAR:
+                if (!readVarint(cur, end, v)) return false;
+                appendPackedValue<int32_t>(out, ARG_CHAR, static_cast<int32_t>(zigzagDecode(v)));
+                break;
+            case ARG_STRING:
+                if (!readVarint(cur, end, v) || static_cast<uint64_t>(end - cur) < v) return false;
+                appendPackedString(out, cur, v);
+                cur += v;
+                break;
+            case ARG_DOUBLE:
+            case ARG_LONG_DOUBLE: {
+                size_t len = type == ARG_DOUBLE ? sizeof(double) : sizeof(long double);
+                if (static_cast<size_t>(end - cur) < len) return false;
+                out.push_back(static_cast<char>(type));
+                out.append(cur, len);
+                cur += len;
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+void BinaryLogEncoder::reset() {
+    sessionStarted = false;
+    lastTimestamp = 0;
+    definedSites.clear();
+}
+
+void BinaryLogEncoder::beginSession(std::string& out, TimePrecision precision) {
+    out.push_back(static_cast<char>(TAG_SESSION));
+    out.append(kSessionMagic, kSessionMagicLen);
+    out.push_back(static_cast<char>(kFormatVersion));
+    out.push_back(static_cast<char>(precision));
+    sessionStarted = true;
+}
+
+void BinaryLogEncoder::appendTimestamp(std::string& out, uint64_t timestampNs) {
+    appendVarint(out, zigzagEncode(static_cast<int64_t>(timestampNs - lastTimestamp)));
+    lastTimestamp = timestampNs;
+}
+
+void BinaryLogEncoder::encodeRecord(std::string& out, uint32_t callSiteId, const LogCallSite& site,
+                                    uint64_t timestampNs, LogLevel_en level, const char* args, size_t argsLen,
+                                    TimePrecision precision) {
+    if (!sessionStarted) beginSession(out, precision);
+
+    if (callSiteId >= definedSites.size()) definedSites.resize(callSiteId + 1, false);
+    if (!definedSites[callSiteId]) {
+        const char* file = site.file ? site.file : "";
+        size_t fileLen = strlen(file);
+        out.push_back(static_cast<char>(TAG_CALL_SITE));
+        appendVarint(out, callSiteId);
+        out.push_back(static_cast<char>(site.level));
+        appendVarint(out, static_cast<uint64_t>(site.line));
+        appendVarint(out, fileLen);
+        out.append(file, fileLen);
+        appendVarint(out, site.format.size());
+        out.append(site.format);
+        definedSites[callSiteId] = true;
+    }
+
+    out.push_back(static_cast<char>(TAG_RECORD));
+    appendVarint(out, callSiteId);
+    appendTimestamp(out, timestampNs);
+    out.push_back(static_cast<char>(level));
+
+    // 紧凑参数先追加到末尾，长度确定后再插入长度前缀
+    size_t lengthPos = out.size();
+    compactArgs(out, args, argsLen);
+    std::string length;
+    appendVarint(length, out.size() - lengthPos);
+    out.insert(lengthPos, length);
+}
+
+void BinaryLogEncoder::encodeText(std::string& out, uint64_t timestampNs, LogLevel_en level, const char* text,
+                                  size_t len, TimePrecision precision) {
+    if (!sessionStarted) beginSession(out, precision);
+    out.push_back(static_cast<char>(TAG_TEXT));
+    appendTimestamp(out, timestampNs);
+    out.push_back(static_cast<char>(level));
+    appendVarint(out, len);
+    out.append(text, len);
+}
+
+BinaryLogDecoder::BinaryLogDecoder(const char* data, size_t size) : cur(data), end(data + size) {}
+
+bool BinaryLogDecoder::fail(const char* what) {
+    errorMessage = what;
+    cur = end;
+    return false;
+}
+
+bool BinaryLogDecoder::readSessionHeader() {
+    if (static_cast<size_t>(end - cur) < kSessionMagicLen + 2 || memcmp(cur, kSessionMagic, kSessionMagicLen) != 0) {
+        return fail("bad session header");
+    }
+    cur += kSessionMagicLen;
+    uint8_t version = static_cast<uint8_t>(*cur++);
+    uint8_t precision = static_cast<uint8_t>(*cur++);
+    if (version != kFormatVersion) return fail("unsupported format version");
+    if (precision > NANOSECONDS) return fail("bad time precision");
+
+    sessionPrecision = static_cast<TimePrecision>(precision);
+    lastTimestamp = 0;
+    sites.clear();
+    return true;
+}
+
+bool BinaryLogDecoder::readCallSite() {
+    uint64_t id, line;
+    if (!readVarint(cur, end, id) || id == 0 || id > UINT32_MAX || cur >= end) return fail("bad call site");
+    uint8_t level = static_cast<uint8_t>(*cur++);
+    if (id >= sites.size()) sites.resize(id + 1);
+    DecodedCallSite& site = sites[id];
+    if (level < DEBUG || level > FATAL || !readVarint(cur, end, line) ||
+        !readBytes(cur, end, site.file) || !readBytes(cur, end, site.format)) {
+        return fail("bad call site");
+    }
+    site.level = static_cast<LogLevel_en>(level);
+    site.line = static_cast<int>(line);
+    site.defined = true;
+    return true;
+}
+
+bool BinaryLogDecoder::next(DecodedLogRecord& record) {
+    while (cur < end) {
+        uint8_t tag = static_cast<uint8_t>(*cur++);
+        if (tag == TAG_SESSION) {
+            if (!readSessionHeader()) return false;
+            continue;
+        }
+        if (tag == TAG_CALL_SITE) {
+            if (!readCallSite()) return false;
+            continue;
+        }
+        if (tag != TAG_RECORD && tag != TAG_TEXT) return fail("unknown record tag");
+
+        uint64_t id = 0;
+        if (tag == TAG_RECORD && (!readVarint(cur, end, id) || id >= sites.size() || !sites[id].defined)) {
+            return fail("record refers to undefined call site");
+        }
+        uint64_t delta, len;
+        if (!readVarint(cur, end, delta) || cur >= end) return fail("truncated record");
+        uint8_t level = static_cast<uint8_t>(*cur++);
+        if (level < DEBUG || level > FATAL) return fail("bad log level");
+        if (!readVarint(cur, end, len) || static_cast<uint64_t>(end - cur) < len) return fail("truncated record");
+
+        lastTimestamp += static_cast<uint64_t>(zigzagDecode(delta));
+        record.timestamp = lastTimestamp;
+        record.level = static_cast<LogLevel_en>(level);
+        record.message.clear();
+        const char* payload = cur;
+        cur += len;
+
+        if (tag == TAG_TEXT) {
+            record.preformatted = true;
+            record.file = nullptr;
+            record.line = 0;
+            record.message.assign(payload, len);
+            return true;
+        }
+
+        const DecodedCallSite& site = sites[id];
+        args.clear();
+        if (!expandArgs(payload, payload + len, args)) return fail("bad packed arguments");
+        record.preformatted = false;
+        record.file = site.file.c_str();
+        record.line = site.line;
+        formatPackedArgs(site.format.c_str(), args.data(), args.size(), record.message);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,87 @@
+#ifndef LOG_BINARY_FORMAT_H
+#define LOG_BINARY_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "LogLevel.h"
+#include "LogCallSite.h"
+
+// 紧凑二进制日志格式。文件由若干会话组成，每次打开文件写入时开始一个新会话：
+//   会话头:   0x7F "LOGSYSB1" u8 版本 u8 时间精度
+//   调用点:   0x01 varint 编号, u8 等级, varint 行号, varint 长度 + 文件名, varint 长度 + 格式串
+//   记录:     0x02 varint 调用点编号, zigzag varint 时间差(ns), u8 等级, varint 长度 + 紧凑参数
+//   文本记录: 0x03 zigzag varint 时间差(ns), u8 等级, varint 长度 + 已格式化文本
+// 调用点定义在会话中首次用到时写出一次；时间差相对于会话内上一条记录。
+// 紧凑参数与 LogArgs 编码一一对应，整数改为 varint、字符串长度改为 varint。
+
+// 写线程使用的编码器
+class BinaryLogEncoder {
+public:
+    // 开始新文件或新会话：下一次编码前重新写出会话头和调用点定义
+    void reset();
+
+    // 编码一条延迟格式化记录，追加到 out
+    void encodeRecord(std::string& out, uint32_t callSiteId, const LogCallSite& site, uint64_t timestampNs,
+                      LogLevel_en level, const char* args, size_t argsLen, TimePrecision precision);
+
+    // 编码一条已格式化的文本记录，追加到 out
+    void encodeText(std::string& out, uint64_t timestampNs, LogLevel_en level, const char* text, size_t len,
+                    TimePrecision precision);
+
+private:
+    void beginSession(std::string& out, TimePrecision precision);
+    void appendTimestamp(std::string& out, uint64_t timestampNs);
+
+    bool sessionStarted = false;           // 当前文件是否已写出会话头
+    uint64_t lastTimestamp = 0;            // 会话内上一条记录的时间戳
+    std::vector<bool> definedSites;        // 当前会话已写出定义的调用点
+};
+
+// 解码出的一条记录
+struct DecodedLogRecord {
+    uint64_t timestamp = 0;                // 自 epoch 起的纳秒数
+    LogLevel_en level = INFO;
+    bool preformatted = false;             // 为 true 时 message 是完整的已格式化文本
+    const char* file = nullptr;
+    int line = 0;
+    std::string message;                   // 格式化后的消息正文
+};
+
+// 离线解码器：输入整份文件内容，逐条取出记录
+class BinaryLogDecoder {
+public:
+    BinaryLogDecoder(const char* data, size_t size);
+
+    // 读取下一条记录，到达末尾或遇到损坏数据时返回 false（后者 error() 非空）
+    bool next(DecodedLogRecord& record);
+
+    // 当前会话记录时使用的时间精度
+    TimePrecision precision() const { return sessionPrecision; }
+
+    const std::string& error() const { return errorMessage; }
+
+private:
+    struct DecodedCallSite {
+        std::string file;
+        int line = 0;
+        LogLevel_en level = INFO;
+        std::string format;
+        bool defined = false;
+    };
+
+    bool readSessionHeader();
+    bool readCallSite();
+    bool fail(const char* what);
+
+    const char* cur;
+    const char* end;
+    TimePrecision sessionPrecision = MILLISECONDS;
+    uint64_t lastTimestamp = 0;
+    std::vector<DecodedCallSite> sites;
+    std::string args;                      // 还原出的 LogArgs 编码参数
+    std::string errorMessage;
+};
+
+#endif // LOG_BINARY_FORMAT_H
@@ -0,0 +1,172 @@
+#include "LogCallSite.h"
+#include <cstring>
+
+namespace {
+
+// 线程局部的调用点缓存：按 (文件指针, 行号, 等级) 直接映射
+struct CallSiteCacheEntry {
+    const char* file = nullptr;
+    int line = 0;
+    int level = 0;
+    uint32_t id = 0;
+};
+
+const size_t kCallSiteCacheSize = 256;
+thread_local CallSiteCacheEntry callSiteCache[kCallSiteCacheSize];
+
+} // namespace
+
+LogCallSiteRegistry& LogCallSiteRegistry::instance() {
+    static LogCallSiteRegistry registry;
+    return registry;
+}
+
+LogCallSiteRegistry::LogCallSiteRegistry() : chunks(new std::atomic<LogCallSite**>[kMaxChunks]) {
+    for (size_t i = 0; i < kMaxChunks; ++i) {
+        chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+const LogCallSite& LogCallSiteRegistry::registerSite(const char* file, int line, const char* function,
+                                                     LogLevel_en level, const char* format) {
+    size_t slot = (reinterpret_cast<uintptr_t>(file) ^ (static_cast<size_t>(line) * 31) ^ level) % kCallSiteCacheSize;
+    CallSiteCacheEntry& cached = callSiteCache[slot];
+    if (cached.id != 0 && cached.file == file && cached.line == line && cached.level == level) {
+        const LogCallSite* site = find(cached.id);
+        if (site->format == format) { // 同一行可能使用不同格式串
+            if (function && !site->function.load(std::memory_order_relaxed)) {
+                const_cast<LogCallSite*>(site)->function.store(function, std::memory_order_relaxed);
+            }
+            return *site;
+        }
+    }
+
+    std::string key = std::string(file ? file : "") + ':' + std::to_string(line) + ':' +
+                      std::to_string(level) + '\0' + format;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    LogCallSite* site;
+    auto it = index.find(key);
+    if (it != index.end()) {
+        site = chunks[it->second >> kChunkBits].load(std::memory_order_relaxed)[it->second & (kChunkSize - 1)];
+        if (function && !site->function.load(std::memory_order_relaxed)) {
+            site->function.store(function, std::memory_order_relaxed);
+        }
+    } else {
+        uint32_t id = count.load(std::memory_order_relaxed);
+        size_t chunk = id >> kChunkBits;
+        if (chunk >= kMaxChunks) return invalidSite; // 调用点过多，按无效编号处理
+        if (!chunks[chunk].load(std::memory_order_relaxed)) {
+            chunkStorage.emplace_back(new LogCallSite*[kChunkSize]());
+            chunks[chunk].store(chunkStorage.back().get(), std::memory_order_release);
+        }
+
+        std::unique_ptr<LogCallSite> owned(new LogCallSite);
+        site = owned.get();
+        site->id = id;
+        if (file) {
+            site->fileName = file;
+            site->file = site->fileName.c_str();
+        }
+        site->line = line;
+        site->level = level;
+        site->format = format;
+        site->function.store(function, std::memory_order_relaxed);
+        for (const OverrideRule& rule : overrideRules) {
+            if (siteMatches(rule.match, *site)) site->levelOverride.store(rule.levelOverride, std::memory_order_relaxed);
+        }
+        for (const ThrottleRule& rule : throttleRules) {
+            if (siteMatches(rule.match, *site)) site->throttle.configure(rule.config);
+        }
+        chunks[chunk].load(std::memory_order_relaxed)[id & (kChunkSize - 1)] = site;
+        ownedSites.push_back(std::move(owned));
+        index.emplace(std::move(key), id);
+        count.store(id + 1, std::memory_order_release);
+    }
+
+    cached.file = file;
+    cached.line = line;
+    cached.level = level;
+    cached.id = site->id;
+    return *site;
+}
+
+const LogCallSite* LogCallSiteRegistry::find(uint32_t id) const {
+    if (id == 0 || id >= count.load(std::memory_order_acquire)) return nullptr;
+    return chunks[id >> kChunkBits].load(std::memory_order_acquire)[id & (kChunkSize - 1)];
+}
+
+size_t LogCallSiteRegistry::size() const {
+    return count.load(std::memory_order_acquire) - 1;
+}
+
+void LogCallSiteRegistry::forEach(const std::function<void(const LogCallSite&)>& fn) const {
+    uint32_t end = count.load(std::memory_order_acquire);
+    for (uint32_t id = 1; id < end; ++id) {
+        fn(*find(id));
+    }
+}
+
+bool LogCallSiteRegistry::siteMatches(const SiteMatch& match, const LogCallSite& site) {
+    if (match.line != 0 && match.line != site.line) return false;
+    if (!site.file) return match.file.empty();
+    size_t len = strlen(site.file);
+    return len >= match.file.size() &&
+           match.file.compare(0, std::string::npos, site.file + len - match.file.size()) == 0;
+}
+
+size_t LogCallSiteRegistry::setLevelOverride(const std::string& file, int line, CallSiteLevelOverride levelOverride) {
+    std::lock_guard<std::mutex> lock(mutex);
+    OverrideRule rule{SiteMatch{file, line}, levelOverride};
+    overrideRules.push_back(rule);
+
+    size_t matched = 0;
+    uint32_t end = count.load(std::memory_order_relaxed);
+    for (uint32_t id = 1; id < end; ++id) {
+        LogCallSite* site = chunks[id >> kChunkBits].load(std::memory_order_relaxed)[id & (kChunkSize - 1)];
+        if (siteMatches(rule.match, *site)) {
+            site->levelOverride.store(levelOverride, std::memory_order_relaxed);
+            ++matched;
+        }
+    }
+    return matched;
+}
+
+void LogCallSiteRegistry::clearLevelOverrides() {
+    std::lock_guard<std::mutex> lock(mutex);
+    overrideRules.clear();
+    uint32_t end = count.load(std::memory_order_relaxed);
+    for (uint32_t id = 1; id < end; ++id) {
+        chunks[id >> kChunkBits].load(std::memory_order_relaxed)[id & (kChunkSize - 1)]->levelOverride.store(
+            CALLSITE_DEFAULT, std::memory_order_relaxed);
+    }
+}
+
+size_t LogCallSiteRegistry::setThrottle(const std::string& file, int line, const LogThrottleConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ThrottleRule rule{SiteMatch{file, line}, config};
+    throttleRules.push_back(rule);
+    throttleRuleCount.store(throttleRules.size(), std::memory_order_relaxed);
+
+    size_t matched = 0;
+    uint32_t end = count.load(std::memory_order_relaxed);
+    for (uint32_t id = 1; id < end; ++id) {
+        LogCallSite* site = chunks[id >> kChunkBits].load(std::memory_order_relaxed)[id & (kChunkSize - 1)];
+        if (siteMatches(rule.match, *site)) {
+            site->throttle.configure(config);
+            ++matched;
+        }
+    }
+    return matched;
+}
+
+void LogCallSiteRegistry::clearThrottles() {
+    std::lock_guard<std::mutex> lock(mutex);
+    throttleRules.clear();
+    throttleRuleCount.store(0, std::memory_order_relaxed);
+    uint32_t end = count.load(std::memory_order_relaxed);
+    for (uint32_t id = 1; id < end; ++id) {
+        chunks[id >> kChunkBits].load(std::memory_order_relaxed)[id & (kChunkSize - 1)]->throttle.configure(
+            LogThrottleConfig());
+    }
+}
@@ -0,0 +1,128 @@
+#ifndef LOG_CALL_SITE_H
+#define LOG_CALL_SITE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "LogLevel.h"
+#include "LogThrottle.h"
+
+// 调用点级别的等级覆盖
+enum CallSiteLevelOverride {
+    CALLSITE_DEFAULT = 0,                  // 跟随 Logger 的等级设置
+    CALLSITE_ENABLED,                      // 无论 Logger 等级如何都输出
+    CALLSITE_DISABLED                      // 无论 Logger 等级如何都不输出
+};
+
+// 日志调用点：每个调用点登记一次，记录中只携带 32 位编号，文件、行号、格式串由写线程按编号查回。
+// 日志宏在调用点处用静态引用缓存本对象，等级覆盖与统计也挂在这里
+struct LogCallSite {
+    uint32_t id = 0;                       // 调用点编号，0 表示登记失败
+    const char* file = nullptr;            // 源文件名，指向 fileName
+    std::string fileName;                  // 登记时拷贝的源文件名，调用方传入的字符串不必长期有效
+    int line = 0;                          // 行号
+    LogLevel_en level = INFO;              // 日志等级
+    std::string format;                    // 格式串
+    std::atomic<const char*> function{nullptr}; // 所在函数（__func__），不经宏登记时为空
+
+    mutable std::atomic<int> levelOverride{CALLSITE_DEFAULT}; // 等级覆盖
+    mutable std::atomic<uint64_t> writtenCount{0}; // 写线程已输出的条数
+    mutable std::atomic<uint64_t> droppedCount{0}; // 因缓冲区溢出丢弃的条数
+    mutable std::atomic<uint64_t> suppressedCount{0}; // 被限流或采样丢弃的条数
+
+    mutable LogThrottle throttle;          // 调用点自己的限流配置，未配置时使用 Logger 按等级的配置
+    mutable LogThrottleState throttleState; // 限流状态
+};
+
+// 全局调用点表：登记时加锁，按编号查询和遍历无锁
+class LogCallSiteRegistry {
+public:
+    static LogCallSiteRegistry& instance();
+
+    LogCallSiteRegistry(const LogCallSiteRegistry&) = delete;
+    LogCallSiteRegistry& operator=(const LogCallSiteRegistry&) = delete;
+
+    // 登记调用点并返回调用点对象，同一调用点重复登记返回同一对象；
+    // 带线程局部缓存，命中时不加锁。调用点过多时返回编号为 0 的占位对象
+    const LogCallSite& registerSite(const char* file, int line, const char* function, LogLevel_en level,
+                                    const char* format);
+    const LogCallSite& registerSite(const char* file, int line, const char* function, LogLevel_en level,
+                                    const std::string& format) {
+        return registerSite(file, line, function, level, format.c_str());
+    }
+
+    // 登记调用点并返回编号（从 1 开始）
+    uint32_t intern(const char* file, int line, LogLevel_en level, const char* format) {
+        return registerSite(file, line, nullptr, level, format).id;
+    }
+
+    // 按编号查询调用点，编号无效时返回 nullptr
+    const LogCallSite* find(uint32_t id) const;
+
+    // 已登记的调用点数量
+    size_t size() const;
+
+    // 按编号顺序遍历所有已登记的调用点
+    void forEach(const std::function<void(const LogCallSite&)>& fn) const;
+
+    // 设置等级覆盖：file 匹配源文件名的结尾，line 为 0 时匹配该文件的所有行。
+    // 规则同时对之后登记的调用点生效，返回当前已匹配的调用点数量
+    size_t setLevelOverride(const std::string& file, int line, CallSiteLevelOverride levelOverride);
+
+    // 清除所有等级覆盖
+    void clearLevelOverrides();
+
+    // 设置调用点限流与采样，匹配规则同 setLevelOverride
+    size_t setThrottle(const std::string& file, int line, const LogThrottleConfig& config);
+
+    // 清除所有调用点限流配置
+    void clearThrottles();
+
+    // 是否存在调用点限流规则
+    bool hasThrottleRules() const { return throttleRuleCount.load(std::memory_order_relaxed) != 0; }
+
+private:
+    LogCallSiteRegistry();
+
+    // 调用点匹配条件
+    struct SiteMatch {
+        std::string file;                  // 匹配源文件名的结尾
+        int line;                          // 0 表示任意行
+    };
+
+    // 等级覆盖规则
+    struct OverrideRule {
+        SiteMatch match;
+        CallSiteLevelOverride levelOverride;
+    };
+
+    // 限流规则
+    struct ThrottleRule {
+        SiteMatch match;
+        LogThrottleConfig config;
+    };
+
+    static bool siteMatches(const SiteMatch& match, const LogCallSite& site);
+
+    static const size_t kChunkBits = 10;
+    static const size_t kChunkSize = size_t(1) << kChunkBits;
+    static const size_t kMaxChunks = 4096;
+
+    std::mutex mutex;                      // 保护登记过程与覆盖规则
+    std::atomic<uint32_t> count{1};        // 下一个编号，0 保留为无效编号
+    std::unique_ptr<std::atomic<LogCallSite**>[]> chunks; // 分块存放调用点指针，块一经分配不再移动
+    std::vector<std::unique_ptr<LogCallSite*[]>> chunkStorage; // 各块的存储
+    std::vector<std::unique_ptr<LogCallSite>> ownedSites;      // 调用点对象
+    std::unordered_map<std::string, uint32_t> index;           // 调用点键到编号的索引
+    std::vector<OverrideRule> overrideRules;                   // 等级覆盖规则，按设置顺序生效
+    std::vector<ThrottleRule> throttleRules;                   // 限流规则，按设置顺序生效
+    std::atomic<size_t> throttleRuleCount{0};                  // 限流规则数量
+    LogCallSite invalidSite;                                   // 登记失败时返回的占位对象
+};
+
+#endif // LOG_CALL_SITE_H
@@ -0,0 +1,66 @@
+#include "LogCategory.h"
+#include <stdexcept>
+
+LogCategory::LogCategory(LogCategoryTable& table, const std::string& name, LogCategory* parent)
+    : table(table), name_(name), parent_(parent) {}
+
+// 沿父链找到第一个单独设置的等级，都没有时取 Logger 的等级位图。
+// 只有缓存仍是读到的那个失效值时才写回，否则说明期间又有失效，重新解析
+uint64_t LogCategory::resolve() const {
+    uint64_t seen = cached.load(std::memory_order_acquire);
+    while (seen & kStale) {
+        int mask = -1;
+        for (const LogCategory* category = this; category && mask < 0; category = category->parent_) {
+            mask = category->explicitMask.load(std::memory_order_acquire);
+        }
+        if (mask < 0) mask = static_cast<int>(table.rootMask.load(std::memory_order_acquire));
+
+        uint64_t word = (seen & ~(kStale | kMaskBits)) | (static_cast<uint64_t>(mask) & kMaskBits);
+        if (cached.compare_exchange_weak(seen, word, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            return word;
+        }
+    }
+    return seen;
+}
+
+LogCategory& LogCategoryTable::get(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return getLocked(name);
+}
+
+LogCategory& LogCategoryTable::getLocked(const std::string& name) {
+    if (name.empty() || name.front() == '.' || name.back() == '.' || name.find("..") != std::string::npos) {
+        throw std::invalid_argument("Invalid log category name: " + name);
+    }
+    std::unique_ptr<LogCategory>& slot = categories[name];
+    if (!slot) {
+        size_t dot = name.rfind('.');
+        LogCategory* parent = dot == std::string::npos ? nullptr : &getLocked(name.substr(0, dot));
+        slot.reset(new LogCategory(*this, name, parent));
+    }
+    return *slot;
+}
+
+void LogCategoryTable::setMask(const std::string& name, int mask) {
+    std::lock_guard<std::mutex> lock(mutex);
+    getLocked(name).explicitMask.store(mask < 0 ? -1 : mask & static_cast<int>(LogCategory::kMaskBits),
+                                       std::memory_order_release);
+    invalidateLocked(name);
+}
+
+void LogCategoryTable::invalidateAll() {
+    std::lock_guard<std::mutex> lock(mutex);
+    invalidateLocked(std::string());
+}
+
+// 先写入新等级再标记失效：失效之前完成的解析会被覆盖，之后的解析必然读到新等级
+void LogCategoryTable::invalidateLocked(const std::string& prefix) {
+    uint64_t stale = (++generation << LogCategory::kGenerationShift) | LogCategory::kStale;
+    for (auto& entry : categories) {
+        const std::string& name = entry.first;
+        if (prefix.empty() || name == prefix ||
+            (name.size() > prefix.size() && name.compare(0, prefix.size(), prefix) == 0 && name[prefix.size()] == '.')) {
+            entry.second->cached.store(stale, std::memory_order_release);
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef LOG_CATEGORY_H
+#define LOG_CATEGORY_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "LogLevel.h"
+
+class LogCategoryTable;
+
+// 日志类别句柄：点分名称构成层级（net、net.rpc、storage.compaction）。
+// 没有单独设置等级的类别继承最近的已设置祖先，顶层类别之上是 Logger 的等级位图。
+// 生效等级解析一次后缓存在 cached 中，热路径只读这一个字
+class LogCategory {
+public:
+    LogCategory(const LogCategory&) = delete;
+    LogCategory& operator=(const LogCategory&) = delete;
+
+    const std::string& name() const { return name_; }
+    const LogCategory* parent() const { return parent_; }
+
+    // 一次原子读、一次失效判断；缓存失效时重新解析
+    bool isEnabled(LogLevel_en level) const {
+        uint64_t word = cached.load(std::memory_order_acquire);
+        if (word & kStale) word = resolve();
+        return (word >> (level - 1)) & 1u;
+    }
+
+private:
+    friend class LogCategoryTable;
+
+    // cached 的布局：低 5 位为等级位图，kStale 位表示需要重新解析，第 8 位起为失效时的代数。
+    // 代数保证每次失效写入的值都不同，解析结果只有在其间没有新的失效时才能写回
+    static const uint64_t kMaskBits = 0x1F;
+    static const uint64_t kStale = 0x80;
+    static const int kGenerationShift = 8;
+
+    LogCategory(LogCategoryTable& table, const std::string& name, LogCategory* parent);
+
+    uint64_t resolve() const;
+
+    LogCategoryTable& table;
+    const std::string name_;
+    LogCategory* const parent_;            // 顶层类别为 nullptr
+    std::atomic<int> explicitMask{-1};     // 单独设置的等级位图，-1 表示继承
+    mutable std::atomic<uint64_t> cached{kStale}; // 缓存的生效等级位图
+};
+
+// 一个 Logger 的全部类别。句柄创建后在表的生命周期内有效；
+// 设置等级时递增代数，并把该类别及其子孙的缓存标记为失效
+class LogCategoryTable {
+public:
+    explicit LogCategoryTable(const std::atomic<uint32_t>& rootMask) : rootMask(rootMask) {}
+
+    LogCategoryTable(const LogCategoryTable&) = delete;
+    LogCategoryTable& operator=(const LogCategoryTable&) = delete;
+
+    // 获取类别，不存在时连同各级父类别一起创建
+    LogCategory& get(const std::string& name);
+
+    // 设置类别的等级位图，mask 为 -1 时恢复继承
+    void setMask(const std::string& name, int mask);
+
+    // 根等级（Logger 的等级位图）变化后使全部缓存失效
+    void invalidateAll();
+
+private:
+    friend class LogCategory;
+
+    LogCategory& getLocked(const std::string& name);
+    void invalidateLocked(const std::string& prefix); // prefix 为空时使全部失效
+
+    const std::atomic<uint32_t>& rootMask;
+    std::mutex mutex;                      // 保护 categories，串行化失效
+    std::map<std::string, std::unique_ptr<LogCategory>> categories;
+    uint64_t generation = 0;               // 失效代数（持有 mutex 时访问）
+};
+
+#endif // LOG_CATEGORY_H
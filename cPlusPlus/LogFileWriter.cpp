@@ -0,0 +1,834 @@
+#include "LogFileWriter.h"
+#include "LogWorkerPool.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#define LOGSYS_HAVE_IO_URING 1
+#endif
+
+LogWriterStats LogFileWriter::stats() const {
+    LogWriterStats result;
+    result.records = records.load(std::memory_order_relaxed);
+    result.bytes = bytes.load(std::memory_order_relaxed);
+    result.batches = batches.load(std::memory_order_relaxed);
+    result.writeCalls = writeCalls.load(std::memory_order_relaxed);
+    result.syncCalls = syncCalls.load(std::memory_order_relaxed);
+    return result;
+}
+
+void WritevFileWriter::Buffer::append(const char* data, size_t size) {
+    while (size > 0) {
+        if (active == chunks.size()) {
+            chunks.emplace_back(new char[kChunkSize]);
+            used.push_back(0);
+        }
+        size_t n = std::min(size, kChunkSize - used[active]);
+        memcpy(chunks[active].get() + used[active], data, n);
+        used[active] += n;
+        bytes += n;
+        data += n;
+        size -= n;
+        if (used[active] == kChunkSize) ++active;
+    }
+}
+
+void WritevFileWriter::Buffer::clear() {
+    for (size_t i = 0; i <= active && i < used.size(); ++i) used[i] = 0;
+    active = 0;
+    bytes = 0;
+    records = 0;
+}
+
+WritevFileWriter::WritevFileWriter() {
+    LogWorkerPool::instance(); // 先于本对象构造线程池，保证析构时仍可用
+}
+
+WritevFileWriter::~WritevFileWriter() {
+    close();
+}
+
+bool WritevFileWriter::open(const std::string& path) {
+    close();
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    return fd != -1;
+}
+
+void WritevFileWriter::close() {
+    if (fd == -1) return;
+    flush();
+    {
+        std::unique_lock<std::mutex> lock(ioMutex);
+        waitIdle(lock);
+    }
+    ::close(fd);
+    fd = -1;
+}
+
+bool WritevFileWriter::append(const char* data, size_t size, bool newline) {
+    front.append(data, size);
+    if (newline) front.append("\n", 1);
+    ++front.records;
+    return true;
+}
+
+// 前台缓冲区与后台交换后交给 I/O 线程；上一批尚未写完时等待，形成自然的背压
+void WritevFileWriter::flush() {
+    if (front.bytes == 0 || fd == -1) return;
+    {
+        std::unique_lock<std::mutex> lock(ioMutex);
+        waitIdle(lock);
+        std::swap(front, back);
+        backBusy = true;
+        backSync = syncOnFlush;
+    }
+    LogWorkerPool::instance().postIo([this] { writeBack(); });
+}
+
+bool WritevFileWriter::sync() {
+    if (fd == -1) return false;
+    flush();
+    {
+        std::unique_lock<std::mutex> lock(ioMutex);
+        waitIdle(lock);
+    }
+    bump(syncCalls);
+    return fdatasync(fd) == 0;
+}
+
+void WritevFileWriter::waitIdle(std::unique_lock<std::mutex>& lock) {
+    ioCV.wait(lock, [this] { return !backBusy; });
+}
+
+void WritevFileWriter::writeBack() {
+    writeBuffer(back);
+    back.clear();
+    if (backSync) {
+        bump(syncCalls);
+        if (fdatasync(fd) != 0) std::cerr << "Log file sync failed: " << strerror(errno) << std::endl;
+    }
+    std::lock_guard<std::mutex> lock(ioMutex);
+    backBusy = false;
+    ioCV.notify_all();
+}
+
+// 一次 writev 写出所有分块，部分写入时从断点继续；写入失败时只统计已写出的字节，不计记录与批次
+void WritevFileWriter::writeBuffer(Buffer& buffer) {
+    std::vector<struct iovec> iov;
+    iov.reserve(buffer.active + 1);
+    for (size_t i = 0; i <= buffer.active && i < buffer.chunks.size(); ++i) {
+        if (buffer.used[i] == 0) continue;
+        struct iovec v;
+        v.iov_base = buffer.chunks[i].get();
+        v.iov_len = buffer.used[i];
+        iov.push_back(v);
+    }
+
+    size_t first = 0;
+    size_t written = 0;
+    while (first < iov.size()) {
+        int count = static_cast<int>(std::min<size_t>(iov.size() - first, IOV_MAX));
+        ssize_t n = writev(fd, &iov[first], count);
+        bump(writeCalls);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Log file write failed: " << strerror(errno) << std::endl;
+            break;
+        }
+        written += static_cast<size_t>(n);
+        size_t left = static_cast<size_t>(n);
+        while (first < iov.size() && left >= iov[first].iov_len) {
+            left -= iov[first].iov_len;
+            ++first;
+        }
+        if (left > 0) {
+            iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + left;
+            iov[first].iov_len -= left;
+        }
+    }
+
+    bump(bytes, written);
+    if (written < buffer.bytes) return;
+    bump(records, buffer.records);
+    bump(batches);
+}
+
+MmapFileWriter::MmapFileWriter(size_t segmentSize)
+    : segmentSize(segmentSize), pageSize(static_cast<size_t>(sysconf(_SC_PAGESIZE))) {}
+
+MmapFileWriter::~MmapFileWriter() {
+    close();
+}
+
+// 已有文件从逻辑末尾继续写：上次未正常关闭时文件尾部留有预分配的零字节，跳过它们
+bool MmapFileWriter::open(const std::string& path) {
+    close();
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    allocated = static_cast<uint64_t>(st.st_size);
+
+    uint64_t end = allocated;
+    char tail[4096];
+    while (end > 0) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(end, sizeof(tail)));
+        if (pread(fd, tail, n, static_cast<off_t>(end - n)) != static_cast<ssize_t>(n)) break;
+        size_t i = n;
+        while (i > 0 && tail[i - 1] == '\0') --i;
+        end -= n - i;
+        if (i > 0) break;
+    }
+    cursor = end;
+
+    if (!mapWindow(cursor)) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void MmapFileWriter::close() {
+    if (fd == -1) return;
+    flush();
+    unmapWindow();
+    if (ftruncate(fd, static_cast<off_t>(cursor)) != 0) { // 去掉未用完的预分配空间
+        std::cerr << "Log file truncate failed: " << strerror(errno) << std::endl;
+    }
+    ::close(fd);
+    fd = -1;
+    cursor = 0;
+    allocated = 0;
+}
+
+// 扩展或映射失败时整条丢弃：游标退回记录开头，本批剩余记录不再重试
+bool MmapFileWriter::append(const char* data, size_t size, bool newline) {
+    if (fd == -1 || mapFailed) return false;
+    uint64_t begin = cursor;
+    if (!copy(data, size) || (newline && !copy("\n", 1))) {
+        cursor = begin;
+        return false;
+    }
+    ++pendingRecords;
+    pendingBytes_ += size + (newline ? 1 : 0);
+    return true;
+}
+
+// 数据在 memcpy 时已进入页缓存，提交只需记账
+void MmapFileWriter::flush() {
+    mapFailed = false; // 下一批重新尝试映射
+    if (pendingRecords == 0) return;
+    if (syncOnFlush) {
+        bump(syncCalls);
+        if (fdatasync(fd) != 0) std::cerr << "Log file sync failed: " << strerror(errno) << std::endl;
+    }
+    bump(records, pendingRecords);
+    bump(bytes, pendingBytes_);
+    bump(batches);
+    pendingRecords = 0;
+    pendingBytes_ = 0;
+}
+
+// 共享映射写脏的页同样由 fdatasync 写回
+bool MmapFileWriter::sync() {
+    if (fd == -1) return false;
+    flush();
+    bump(syncCalls);
+    return fdatasync(fd) == 0;
+}
+
+bool MmapFileWriter::logicalSize(uint64_t& size) const {
+    if (fd == -1) return false;
+    size = cursor;
+    return true;
+}
+
+bool MmapFileWriter::copy(const char* data, size_t size) {
+    while (size > 0) {
+        if (!window || cursor >= windowOffset + windowLength) {
+            unmapWindow();
+            if (!mapWindow(cursor)) {
+                std::cerr << "Log file mmap failed: " << strerror(errno) << std::endl;
+                mapFailed = true;
+                return false;
+            }
+        }
+        size_t n = static_cast<size_t>(std::min<uint64_t>(size, windowOffset + windowLength - cursor));
+        memcpy(window + (cursor - windowOffset), data, n);
+        cursor += n;
+        data += n;
+        size -= n;
+
+        // 已写满的页不会再访问，解除映射以控制常驻内存；脏页仍保留在页缓存中等待回写
+        if (cursor - released >= kReleaseStep) {
+            uint64_t end = cursor & ~static_cast<uint64_t>(pageSize - 1);
+            madvise(window + (released - windowOffset), end - released, MADV_DONTNEED);
+            bump(writeCalls);
+            released = end;
+        }
+    }
+    return true;
+}
+
+// 窗口超出已分配长度时扩展：首次扩展到整段，段写满后（滚动尚未触发）按窗口大小增长。
+// 段内的窗口不越过段尾，小于窗口大小的段只分配并映射段大小
+bool MmapFileWriter::mapWindow(uint64_t offset) {
+    uint64_t start = offset & ~static_cast<uint64_t>(pageSize - 1);
+    uint64_t end = start + kWindowSize;
+    if (offset < segmentSize) end = std::min<uint64_t>(end, segmentSize);
+    if (end > allocated) {
+        uint64_t target = std::max<uint64_t>(end, segmentSize);
+        if (fallocate(fd, 0, static_cast<off_t>(allocated), static_cast<off_t>(target - allocated)) != 0) {
+            // 仅在文件系统不支持 fallocate 时退化为稀疏文件；空间不足等错误直接失败，
+            // 否则写入稀疏文件的缺页会在磁盘满时触发 SIGBUS
+            if ((errno != EOPNOTSUPP && errno != ENOSYS) || ftruncate(fd, static_cast<off_t>(target)) != 0) {
+                return false;
+            }
+        }
+        bump(writeCalls);
+        allocated = target;
+    }
+
+    void* p = mmap(nullptr, end - start, PROT_READ | PROT_WRITE, MAP_SHARED, fd, static_cast<off_t>(start));
+    bump(writeCalls);
+    if (p == MAP_FAILED) return false;
+    window = static_cast<char*>(p);
+    windowOffset = start;
+    windowLength = end - start;
+    released = start;
+    return true;
+}
+
+void MmapFileWriter::unmapWindow() {
+    if (!window) return;
+    munmap(window, windowLength);
+    bump(writeCalls);
+    window = nullptr;
+    windowLength = 0;
+}
+
+#ifdef LOGSYS_HAVE_IO_URING
+
+// 直接使用系统调用与共享内存环，不依赖 liburing
+struct UringFileWriter::Ring {
+    static const unsigned kEntries = 2 * kSlotCount; // 每块缓冲区最多一个写入加一个 fdatasync
+    static const uint64_t kSyncTag = ~0ull;          // fdatasync 完成项的 user_data
+
+    int fd = -1;
+    bool fixedBuffers = false;              // 缓冲区是否注册成功，否则使用普通 WRITE
+    void* sqRing = MAP_FAILED;
+    size_t sqRingSize = 0;
+    void* cqRing = MAP_FAILED;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    unsigned toSubmit = 0;                  // 已填写尚未投递的提交项
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+        if (cqRing != MAP_FAILED && cqRing != sqRing) munmap(cqRing, cqRingSize);
+        if (sqRing != MAP_FAILED) munmap(sqRing, sqRingSize);
+        if (fd != -1) ::close(fd);
+    }
+
+    bool setup() {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, kEntries, &params));
+        if (fd < 0) {
+            fd = -1;
+            return false;
+        }
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) return false;
+        cqRing = single ? sqRing
+                        : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                               IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) return false;
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(
+            mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) return false;
+
+        char* sq = static_cast<char*>(sqRing);
+        char* cq = static_cast<char*>(cqRing);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    bool registerBuffers(Slot* slots, size_t count) {
+        struct iovec iov[kSlotCount];
+        for (size_t i = 0; i < count; ++i) {
+            iov[i].iov_base = slots[i].data.get();
+            iov[i].iov_len = kSlotSize;
+        }
+        fixedBuffers = syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, iov, count) == 0;
+        return fixedBuffers;
+    }
+
+    // 取一个空闲提交项；每次投递后提交队列即被内核取空，不会耗尽
+    io_uring_sqe* nextSqe() {
+        unsigned tail = *sqTail + toSubmit;
+        unsigned index = tail & *sqMask;
+        sqArray[index] = index;
+        ++toSubmit;
+        io_uring_sqe* sqe = &sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    // 投递已填写的提交项，并至少等待 minComplete 个完成
+    int enter(unsigned minComplete) {
+        __atomic_store_n(sqTail, *sqTail + toSubmit, __ATOMIC_RELEASE);
+        unsigned submit = toSubmit;
+        toSubmit = 0;
+        unsigned flags = minComplete ? IORING_ENTER_GETEVENTS : 0;
+        while (true) {
+            int ret = static_cast<int>(syscall(__NR_io_uring_enter, fd, submit, minComplete, flags, nullptr, 0));
+            if (ret >= 0 || errno != EINTR) return ret;
+            submit = 0; // 被信号打断时提交项已被取走，只需继续等待
+        }
+    }
+};
+
+UringFileWriter::UringFileWriter() {
+    for (Slot& slot : slots) slot.data.reset(new char[kSlotSize]);
+    std::unique_ptr<Ring> r(new Ring);
+    if (r->setup()) {
+        r->registerBuffers(slots, kSlotCount);
+        ring = std::move(r);
+    }
+}
+
+UringFileWriter::~UringFileWriter() {
+    close();
+}
+
+// 写入使用显式偏移，不依赖 O_APPEND
+bool UringFileWriter::open(const std::string& path) {
+    close();
+    if (!ring) return false;
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    offset = static_cast<uint64_t>(st.st_size);
+    return true;
+}
+
+void UringFileWriter::close() {
+    if (fd == -1) return;
+    flush();
+    waitAll();
+    ::close(fd);
+    fd = -1;
+}
+
+bool UringFileWriter::append(const char* data, size_t size, bool newline) {
+    if (fd == -1) return false;
+    copy(data, size);
+    if (newline) copy("\n", 1);
+    ++slots[active].records;
+    return true;
+}
+
+void UringFileWriter::copy(const char* data, size_t size) {
+    while (size > 0) {
+        Slot& slot = slots[active];
+        size_t n = std::min(size, kSlotSize - slot.used);
+        memcpy(slot.data.get() + slot.used, data, n);
+        slot.used += n;
+        data += n;
+        size -= n;
+        if (slot.used == kSlotSize) submit(syncOnFlush); // 缓冲区满，先行投递
+    }
+}
+
+void UringFileWriter::flush() {
+    if (fd == -1 || slots[active].used == 0) return;
+    submit(syncOnFlush);
+}
+
+void UringFileWriter::submit(bool linkSync) {
+    Slot& slot = slots[active];
+    io_uring_sqe* sqe = ring->nextSqe();
+    sqe->opcode = ring->fixedBuffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->off = offset;
+    sqe->addr = reinterpret_cast<uint64_t>(slot.data.get());
+    sqe->len = static_cast<uint32_t>(slot.used);
+    sqe->buf_index = static_cast<uint16_t>(active);
+    sqe->user_data = active;
+    if (linkSync) {
+        sqe->flags |= IOSQE_IO_LINK; // 写入成功后才执行 fdatasync
+        io_uring_sqe* syncSqe = ring->nextSqe();
+        syncSqe->opcode = IORING_OP_FSYNC;
+        syncSqe->fd = fd;
+        syncSqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        syncSqe->user_data = Ring::kSyncTag;
+        bump(syncCalls);
+    }
+
+    if (ring->enter(0) < 0) {
+        std::cerr << "io_uring submit failed: " << strerror(errno) << std::endl;
+    }
+    bump(writeCalls);
+    bump(records, slot.records);
+    bump(bytes, slot.used);
+    bump(batches);
+    slot.offset = offset;
+    offset += slot.used;
+    slot.syncLinked = linkSync;
+    slot.inflight = true;
+    ++inflight;
+
+    active = (active + 1) % kSlotCount;
+    reap();
+    if (!waitSlot(active)) { // 所有缓冲区都在途时等待最早的一块写完
+        std::cerr << "io_uring wait failed: " << strerror(errno) << std::endl;
+    }
+}
+
+bool UringFileWriter::waitSlot(size_t index) {
+    while (slots[index].inflight) {
+        if (ring->enter(1) < 0) return false;
+        reap();
+    }
+    return true;
+}
+
+void UringFileWriter::waitAll() {
+    while (inflight > 0) {
+        if (ring->enter(1) < 0) {
+            std::cerr << "io_uring wait failed: " << strerror(errno) << std::endl;
+            return;
+        }
+        reap();
+    }
+}
+
+// 短写在文件上极少发生，出现时用 pwrite 同步补齐剩余部分
+void UringFileWriter::reap() {
+    unsigned head = *ring->cqHead;
+    unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+        const io_uring_cqe& cqe = ring->cqes[head & *ring->cqMask];
+        if (cqe.user_data == Ring::kSyncTag) { // 被取消的已在对应写入的完成项中补做
+            if (cqe.res < 0 && cqe.res != -ECANCELED) {
+                std::cerr << "Log file sync failed: " << strerror(-cqe.res) << std::endl;
+            }
+            continue;
+        }
+
+        Slot& slot = slots[cqe.user_data];
+        if (cqe.res < 0) {
+            std::cerr << "Log file write failed: " << strerror(-cqe.res) << std::endl;
+        } else if (static_cast<size_t>(cqe.res) < slot.used) {
+            size_t done = static_cast<size_t>(cqe.res);
+            while (done < slot.used) {
+                ssize_t n = pwrite(fd, slot.data.get() + done, slot.used - done, static_cast<off_t>(slot.offset + done));
+                bump(writeCalls);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) {
+                    std::cerr << "Log file write failed: " << strerror(errno) << std::endl;
+                    break;
+                }
+                done += static_cast<size_t>(n);
+            }
+        }
+        // 写入失败或短写会取消链接的 fdatasync，在释放缓冲区之前同步补做
+        if (slot.syncLinked && (cqe.res < 0 || static_cast<size_t>(cqe.res) < slot.used) && fdatasync(fd) != 0) {
+            std::cerr << "Log file sync failed: " << strerror(errno) << std::endl;
+        }
+        slot.syncLinked = false;
+        slot.used = 0;
+        slot.records = 0;
+        slot.inflight = false;
+        --inflight;
+    }
+    __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+}
+
+#else // 没有 io_uring 头文件的平台：available() 恒为 false
+
+struct UringFileWriter::Ring {};
+
+UringFileWriter::UringFileWriter() {}
+UringFileWriter::~UringFileWriter() {}
+bool UringFileWriter::open(const std::string&) { return false; }
+void UringFileWriter::close() {}
+void UringFileWriter::append(const char*, size_t, bool) {}
+void UringFileWriter::flush() {}
+void UringFileWriter::copy(const char*, size_t) {}
+void UringFileWriter::submit(bool) {}
+bool UringFileWriter::waitSlot(size_t) { return true; }
+void UringFileWriter::waitAll() {}
+void UringFileWriter::reap() {}
+
+#endif // LOGSYS_HAVE_IO_URING
+
+bool UringFileWriter::sync() {
+    if (fd == -1) return false;
+    flush();
+    waitAll();
+    bump(syncCalls);
+    return fdatasync(fd) == 0;
+}
+
+size_t UringFileWriter::pendingBytes() const {
+    return slots[active].used;
+}
+
+// 在途写入尚未反映在文件大小中，以投递偏移为准
+bool UringFileWriter::logicalSize(uint64_t& size) const {
+    if (fd == -1) return false;
+    size = offset + slots[active].used;
+    return true;
+}
+
+DirectFileWriter::DirectFileWriter(bool direct) : wantDirect(direct) {
+    void* p = nullptr;
+    if (posix_memalign(&p, kBlockSize, kBufferSize) != 0) throw std::bad_alloc();
+    buffer = static_cast<char*>(p);
+}
+
+DirectFileWriter::~DirectFileWriter() {
+    close();
+    free(buffer);
+}
+
+// 已有文件的不完整末块先读回缓冲区，之后与新数据一起整块写出
+bool DirectFileWriter::open(const std::string& path) {
+    close();
+    direct = wantDirect;
+    if (direct) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_DIRECT | O_CLOEXEC, 0644);
+        if (fd == -1 && errno == EINVAL) {
+            std::cerr << "O_DIRECT is not supported for " << path << ", using posix_fadvise streaming" << std::endl;
+            direct = false;
+        }
+    }
+    if (!direct) fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    uint64_t size = static_cast<uint64_t>(st.st_size);
+    offset = direct ? size & ~static_cast<uint64_t>(kBlockSize - 1) : size;
+    used = written = static_cast<size_t>(size - offset);
+    advised = writebackFrom = size;
+    if (used > 0) {
+        int in = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        bool ok = in != -1 && pread(in, buffer, used, static_cast<off_t>(offset)) == static_cast<ssize_t>(used);
+        if (in != -1) {
+            posix_fadvise(in, static_cast<off_t>(offset), used, POSIX_FADV_DONTNEED);
+            ::close(in);
+        }
+        if (!ok) {
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+    }
+    return true;
+}
+
+void DirectFileWriter::close() {
+    if (fd == -1) return;
+    flush();
+    if (!direct) { // 等待剩余数据写回后释放整个文件的页缓存
+        sync_file_range(fd, static_cast<off_t>(advised), 0,
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+    ::close(fd);
+    fd = -1;
+    used = written = 0;
+    offset = 0;
+}
+
+bool DirectFileWriter::append(const char* data, size_t size, bool newline) {
+    if (fd == -1) return false;
+    copy(data, size);
+    if (newline) copy("\n", 1);
+    ++pendingRecords;
+    return true;
+}
+
+void DirectFileWriter::copy(const char* data, size_t size) {
+    while (size > 0) {
+        size_t n = std::min(size, kBufferSize - used);
+        memcpy(buffer + used, data, n);
+        used += n;
+        data += n;
+        size -= n;
+        if (used == kBufferSize) writeOut(false);
+    }
+}
+
+void DirectFileWriter::flush() {
+    if (fd == -1 || (pendingRecords == 0 && used == written)) return;
+    writeOut(true);
+    bump(records, pendingRecords);
+    bump(batches);
+    pendingRecords = 0;
+    if (syncOnFlush) {
+        bump(syncCalls);
+        if (fdatasync(fd) != 0) std::cerr << "Log file sync failed: " << strerror(errno) << std::endl;
+    }
+}
+
+bool DirectFileWriter::sync() {
+    if (fd == -1) return false;
+    flush();
+    bump(syncCalls);
+    return fdatasync(fd) == 0;
+}
+
+bool DirectFileWriter::logicalSize(uint64_t& size) const {
+    if (fd == -1) return false;
+    size = offset + used;
+    return true;
+}
+
+void DirectFileWriter::writeOut(bool tail) {
+    if (!direct) {
+        if (used > written) {
+            if (writeAt(buffer + written, used - written, offset + written)) {
+                bump(bytes, used - written);
+            } else { // 丢弃未写出的数据，offset 只越过已写入的部分，文件中不留空洞或残缺的记录
+                used = written;
+                discardPartialWrite(offset + written);
+            }
+        }
+        offset += used;
+        used = written = 0;
+
+        // 启动本批写回；上一批的写回通常已完成，此时释放其页缓存
+        sync_file_range(fd, static_cast<off_t>(writebackFrom), static_cast<off_t>(offset - writebackFrom),
+                        SYNC_FILE_RANGE_WRITE);
+        if (writebackFrom > advised) {
+            posix_fadvise(fd, static_cast<off_t>(advised), static_cast<off_t>(writebackFrom - advised),
+                          POSIX_FADV_DONTNEED);
+            advised = writebackFrom;
+        }
+        writebackFrom = offset;
+        return;
+    }
+
+    size_t full = used & ~(kBlockSize - 1);
+    size_t length = tail ? (used + kBlockSize - 1) & ~(kBlockSize - 1) : full;
+    if (length == 0) return;
+    if (length > used) memset(buffer + used, 0, length - used); // 补零到整块
+    if (!writeAt(buffer, length, offset)) {
+        // 丢弃未写出的数据，只保留已在磁盘上的末块前缀，下次从同一位置重写；
+        // written 总小于一块，copy 因此总能继续前进
+        used = written;
+        discardPartialWrite(offset + written);
+        return;
+    }
+    if (length > used && ftruncate(fd, static_cast<off_t>(offset + used)) != 0) {
+        std::cerr << "Log file truncate failed: " << strerror(errno) << std::endl;
+    }
+
+    size_t done = tail ? used : std::max(written, full);
+    bump(bytes, done - written);
+    size_t rest = used - full; // 不完整的末块留在缓冲区开头
+    if (full > 0) {
+        memmove(buffer, buffer + full, rest);
+        offset += full;
+    }
+    used = rest;
+    written = done - full;
+}
+
+// 写入失败时可能已写出一部分，截掉逻辑长度之后的内容
+void DirectFileWriter::discardPartialWrite(uint64_t end) {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && static_cast<uint64_t>(st.st_size) > end &&
+        ftruncate(fd, static_cast<off_t>(end)) != 0) {
+        std::cerr << "Log file truncate failed: " << strerror(errno) << std::endl;
+    }
+}
+
+bool DirectFileWriter::writeAt(const char* data, size_t size, uint64_t at) {
+    while (size > 0) {
+        ssize_t n = pwrite(fd, data, size, static_cast<off_t>(at));
+        bump(writeCalls);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            std::cerr << "Log file write failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+        at += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+std::unique_ptr<LogFileWriter> createLogFileWriter(FileWriterMode mode, size_t segmentSize) {
+    switch (mode) {
+        case IO_URING_WRITER: {
+            std::unique_ptr<UringFileWriter> writer(new UringFileWriter);
+            if (writer->available()) return std::unique_ptr<LogFileWriter>(writer.release());
+            std::cerr << "io_uring is unavailable, falling back to the writev writer" << std::endl;
+            return std::unique_ptr<LogFileWriter>(new WritevFileWriter);
+        }
+        case MMAP_WRITER:
+            return std::unique_ptr<LogFileWriter>(new MmapFileWriter(segmentSize));
+        case DIRECT_IO_WRITER:
+            return std::unique_ptr<LogFileWriter>(new DirectFileWriter(true));
+        case DONTNEED_WRITER:
+            return std::unique_ptr<LogFileWriter>(new DirectFileWriter(false));
+        case WRITEV_WRITER:
+        default:
+            return std::unique_ptr<LogFileWriter>(new WritevFileWriter);
+    }
+}
@@ -0,0 +1,269 @@
+#ifndef LOG_FILE_WRITER_H
+#define LOG_FILE_WRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 文件写入后端类型
+enum FileWriterMode {
+    WRITEV_WRITER,       // 双缓冲批量 writev（默认）
+    MMAP_WRITER,         // 预分配段 + mmap 窗口 memcpy
+    IO_URING_WRITER,     // io_uring 异步写入，不可用时退回 WRITEV_WRITER
+    DIRECT_IO_WRITER,    // O_DIRECT 对齐块写入，不占用页缓存；文件系统不支持时退回 DONTNEED_WRITER
+    DONTNEED_WRITER      // 普通写入，写回后以 posix_fadvise(DONTNEED) 释放页缓存
+};
+
+// 提交策略：待提交数据满足任一条件即提交一批
+struct LogFlushPolicy {
+    size_t maxBytes = 256 * 1024;          // 累积字节数上限
+    size_t maxRecords = 4096;              // 累积记录数上限
+    std::chrono::microseconds maxLatency{10000}; // 第一条记录最长等待时间，写线程空闲时也会立即提交
+    bool syncEachBatch = false;            // 每批写出后执行 fdatasync
+};
+
+// 文件写入统计
+struct LogWriterStats {
+    uint64_t records = 0;                  // 写入的记录数
+    uint64_t bytes = 0;                    // 写入的字节数
+    uint64_t batches = 0;                  // 提交的批次数
+    uint64_t writeCalls = 0;               // 写入路径上的系统调用次数（write / writev，mmap 模式下为映射切换与释放）
+    uint64_t syncCalls = 0;                // fdatasync 系统调用次数
+
+    void merge(const LogWriterStats& other) {
+        records += other.records;
+        bytes += other.bytes;
+        batches += other.batches;
+        writeCalls += other.writeCalls;
+        syncCalls += other.syncCalls;
+    }
+};
+
+// 日志文件写入后端。append/flush 只由写线程调用，stats 可由任意线程读取
+class LogFileWriter {
+public:
+    virtual ~LogFileWriter() {}
+
+    // 以追加方式打开文件，失败返回 false
+    virtual bool open(const std::string& path) = 0;
+
+    // 提交剩余数据并关闭文件
+    virtual void close() = 0;
+
+    // 追加一条记录，newline 为 true 时在末尾加换行；记录被丢弃（如 mmap 扩展失败）时返回 false
+    virtual bool append(const char* data, size_t size, bool newline) = 0;
+
+    // 把已累积的数据提交给内核，设置了 setSyncOnFlush 时随后落盘
+    virtual void flush() = 0;
+
+    // 每次 flush 写出后是否执行 fdatasync
+    void setSyncOnFlush(bool enable) { syncOnFlush = enable; }
+
+    // 提交并把文件数据落盘
+    virtual bool sync() = 0;
+
+    // 尚未提交的字节数
+    virtual size_t pendingBytes() const = 0;
+
+    // 文件的逻辑长度。预分配空间的后端文件大小不等于已写入长度，需通过此接口获取；
+    // 返回 false 表示调用方应以文件大小为准
+    virtual bool logicalSize(uint64_t& size) const {
+        (void)size;
+        return false;
+    }
+
+    LogWriterStats stats() const;
+
+protected:
+    // 单写者计数器自增
+    static void bump(std::atomic<uint64_t>& counter, uint64_t delta = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> records{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> batches{0};
+    std::atomic<uint64_t> writeCalls{0};
+    std::atomic<uint64_t> syncCalls{0};
+    bool syncOnFlush = false;              // 仅写线程访问
+};
+
+// 批量写入后端：双缓冲，写线程向前台缓冲区追加，提交时与后台缓冲区交换，
+// 由 LogWorkerPool 共享的 I/O 线程用一次 writev 写出后台缓冲区的全部分块，写线程继续填充下一批
+class WritevFileWriter : public LogFileWriter {
+public:
+    WritevFileWriter();
+    ~WritevFileWriter() override;
+
+    bool open(const std::string& path) override;
+    void close() override;
+    bool append(const char* data, size_t size, bool newline) override;
+    void flush() override;
+    bool sync() override;
+    size_t pendingBytes() const override { return front.bytes; }
+
+private:
+    static const size_t kChunkSize = 64 * 1024; // 缓冲区分块大小，增长时不搬移已有数据
+
+    // 由若干定长分块组成的缓冲区，分块在批次之间复用
+    struct Buffer {
+        std::vector<std::unique_ptr<char[]>> chunks;
+        std::vector<size_t> used;          // 各分块已用字节数
+        size_t active = 0;                 // 当前写入的分块
+        size_t bytes = 0;                  // 总字节数
+        size_t records = 0;                // 记录数
+
+        void append(const char* data, size_t size);
+        void clear();
+    };
+
+    void writeBack();                      // I/O 线程：写出后台缓冲区，按需落盘
+    void writeBuffer(Buffer& buffer);      // I/O 线程：writev 写出整个缓冲区
+    void waitIdle(std::unique_lock<std::mutex>& lock); // 等待后台缓冲区写完
+
+    int fd = -1;
+    Buffer front;                          // 写线程填充
+    Buffer back;                           // I/O 线程写出
+
+    std::mutex ioMutex;
+    std::condition_variable ioCV;
+    bool backBusy = false;                 // 后台缓冲区是否待写
+    bool backSync = false;                 // 后台缓冲区写出后是否落盘
+};
+
+// 内存映射写入后端：打开时把文件 fallocate 到段大小，记录经 mmap 窗口 memcpy 写入，
+// 不再每批进行 write 系统调用，也避免文件增长时的块分配停顿。
+// 光标越过的整页用 madvise(MADV_DONTNEED) 释放，关闭（滚动）时把文件截断到实际长度
+class MmapFileWriter : public LogFileWriter {
+public:
+    explicit MmapFileWriter(size_t segmentSize);
+    ~MmapFileWriter() override;
+
+    bool open(const std::string& path) override;
+    void close() override;
+    bool append(const char* data, size_t size, bool newline) override;
+    void flush() override;
+    bool sync() override;
+    size_t pendingBytes() const override { return 0; }
+    bool logicalSize(uint64_t& size) const override;
+
+private:
+    static const size_t kWindowSize = 4 * 1024 * 1024; // 映射窗口大小
+    static const size_t kReleaseStep = 256 * 1024;     // 每写满这么多字节释放一次已写页
+
+    bool copy(const char* data, size_t size);
+    bool mapWindow(uint64_t offset);       // 映射包含 offset 的窗口，必要时扩展预分配
+    void unmapWindow();
+
+    const size_t segmentSize;              // 预分配的段大小
+    const size_t pageSize;
+    int fd = -1;
+    uint64_t cursor = 0;                   // 下一次写入的文件偏移（逻辑长度）
+    uint64_t allocated = 0;                // 已预分配的长度
+    char* window = nullptr;                // 当前映射窗口
+    uint64_t windowOffset = 0;             // 窗口对应的文件偏移（页对齐）
+    uint64_t windowLength = 0;
+    uint64_t released = 0;                 // 已释放到的文件偏移
+    uint64_t pendingRecords = 0;           // 上次 flush 之后写入的记录数
+    uint64_t pendingBytes_ = 0;            // 上次 flush 之后写入的字节数
+    bool mapFailed = false;                // 本批中扩展或映射已失败，之后的记录直接丢弃
+};
+
+// io_uring 写入后端：固定数量的注册缓冲区轮流使用，写线程填满或提交时以 WRITE_FIXED
+// 投递到显式偏移，不等待完成即转向下一块缓冲区，多批写入同时在途；
+// 开启 syncOnFlush 时在写入后链接一个 fdatasync（IOSQE_IO_LINK）。
+// 内核不支持或被禁用 io_uring 时 available() 返回 false，由 createLogFileWriter 退回 writev
+class UringFileWriter : public LogFileWriter {
+public:
+    UringFileWriter();
+    ~UringFileWriter() override;
+
+    bool available() const { return ring != nullptr; }
+
+    bool open(const std::string& path) override;
+    void close() override;
+    bool append(const char* data, size_t size, bool newline) override;
+    void flush() override;
+    bool sync() override;
+    size_t pendingBytes() const override;
+    bool logicalSize(uint64_t& size) const override;
+
+private:
+    static const size_t kSlotCount = 8;             // 缓冲区数量，即最多在途的写入数
+    static const size_t kSlotSize = 256 * 1024;     // 每块缓冲区大小
+
+    struct Ring;                            // 提交/完成队列映射，定义见实现文件
+
+    struct Slot {
+        std::unique_ptr<char[]> data;
+        size_t used = 0;
+        size_t records = 0;
+        uint64_t offset = 0;                // 投递时的文件偏移
+        bool syncLinked = false;            // 投递时链接了 fdatasync
+        bool inflight = false;
+    };
+
+    void copy(const char* data, size_t size);
+    void submit(bool linkSync);             // 投递当前缓冲区并切换到下一块
+    bool waitSlot(size_t index);            // 等待指定缓冲区的写入完成
+    void waitAll();
+    void reap();                            // 收割完成队列中已有的完成项
+
+    std::unique_ptr<Ring> ring;
+    Slot slots[kSlotCount];
+    size_t active = 0;                      // 写线程正在填充的缓冲区
+    size_t inflight = 0;                    // 在途写入数（不含链接的 fdatasync）
+    int fd = -1;
+    uint64_t offset = 0;                    // 下一次投递的文件偏移
+};
+
+// 绕开页缓存的写入后端，避免大量日志挤占应用的热数据。
+// direct 模式：记录累积在 4 KiB 对齐的缓冲区中，以 O_DIRECT 按整块写出；提交时末尾不完整的块
+// 补零写出后用 ftruncate 截回实际长度，该块留在缓冲区开头，下次连同新数据整块重写。
+// 流式模式（O_DIRECT 不可用或显式选择）：普通 pwrite 后用 sync_file_range 启动写回，
+// 上一批已写回的范围以 posix_fadvise(DONTNEED) 从页缓存中释放
+class DirectFileWriter : public LogFileWriter {
+public:
+    explicit DirectFileWriter(bool direct);
+    ~DirectFileWriter() override;
+
+    bool open(const std::string& path) override;
+    void close() override;
+    bool append(const char* data, size_t size, bool newline) override;
+    void flush() override;
+    bool sync() override;
+    size_t pendingBytes() const override { return used - written; }
+    bool logicalSize(uint64_t& size) const override;
+
+private:
+    static const size_t kBlockSize = 4096;          // O_DIRECT 对齐单位
+    static const size_t kBufferSize = 1024 * 1024;  // 缓冲区大小，kBlockSize 的整数倍
+
+    void copy(const char* data, size_t size);
+    void writeOut(bool tail);               // 写出缓冲区，tail 为 true 时连同不完整的末块
+    bool writeAt(const char* data, size_t size, uint64_t at);
+    void discardPartialWrite(uint64_t end);
+
+    const bool wantDirect;                  // 是否请求 O_DIRECT
+    bool direct = false;                    // 当前文件是否以 O_DIRECT 打开
+    int fd = -1;
+    char* buffer = nullptr;                 // kBlockSize 对齐
+    size_t used = 0;                        // 缓冲区已用字节数
+    size_t written = 0;                     // 缓冲区开头已写入文件的字节数
+    uint64_t offset = 0;                    // 缓冲区开头对应的文件偏移，direct 模式下块对齐
+    uint64_t advised = 0;                   // 流式模式下已释放页缓存的位置
+    uint64_t writebackFrom = 0;             // 流式模式下本批启动写回的起点
+    uint64_t pendingRecords = 0;            // 上次 flush 之后追加的记录数
+};
+
+// 按类型创建写入后端，segmentSize 供预分配类后端使用
+std::unique_ptr<LogFileWriter> createLogFileWriter(FileWriterMode mode, size_t segmentSize);
+
+#endif // LOG_FILE_WRITER_H
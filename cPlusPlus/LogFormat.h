@@ -0,0 +1,220 @@
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include "LogArgs.h"
+
+// 编译期 printf 格式串解析（C++11 constexpr，单 return 递归实现）。
+// formatArgKind(fmt, i) 给出第 i 个参数应有的类别，用于：
+//   1. 在编译期校验参数个数与类型；
+//   2. 为每个调用点选择专用的参数打包方式（编码与 LogArgs 相同，由写线程格式化）。
+
+// 格式串期望的参数类别
+enum FormatArgKind {
+    KIND_END,            // 格式串中已没有更多参数
+    KIND_INVALID,        // 不支持的转换（%n、%m、宽字符、位置参数等）
+    KIND_STAR,           // '*' 宽度或精度，int
+    KIND_SIGNED,         // %d %i
+    KIND_UNSIGNED,       // %o %u %x %X
+    KIND_FLOAT,          // %f %e %g %a 等
+    KIND_LONG_DOUBLE,    // %Lf 等
+    KIND_CHAR,           // %c
+    KIND_STRING,         // %s
+    KIND_POINTER         // %p
+};
+
+namespace logformat {
+
+constexpr bool isFlag(char c) {
+    return c == '-' || c == '+' || c == ' ' || c == '#' || c == '0' || c == '\'';
+}
+
+constexpr bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+constexpr bool isLengthChar(char c) {
+    return c == 'h' || c == 'l' || c == 'j' || c == 'z' || c == 't' || c == 'L' || c == 'q';
+}
+
+constexpr const char* skipFlags(const char* p) {
+    return isFlag(*p) ? skipFlags(p + 1) : p;
+}
+
+constexpr const char* skipDigits(const char* p) {
+    return isDigit(*p) ? skipDigits(p + 1) : p;
+}
+
+// 长度修饰符的字符数（最多 2 个）
+constexpr size_t lengthChars(const char* p) {
+    return isLengthChar(p[0]) ? (isLengthChar(p[1]) ? 2 : 1) : 0;
+}
+
+// 由转换字符和长度修饰符得到参数类别
+constexpr FormatArgKind convKind(char conv, char length) {
+    return (conv == 'd' || conv == 'i') ? KIND_SIGNED
+         : (conv == 'o' || conv == 'u' || conv == 'x' || conv == 'X') ? KIND_UNSIGNED
+         : (conv == 'f' || conv == 'F' || conv == 'e' || conv == 'E' ||
+            conv == 'g' || conv == 'G' || conv == 'a' || conv == 'A') ? (length == 'L' ? KIND_LONG_DOUBLE : KIND_FLOAT)
+         : conv == 'c' ? (length ? KIND_INVALID : KIND_CHAR)
+         : conv == 's' ? (length ? KIND_INVALID : KIND_STRING)
+         : conv == 'p' ? KIND_POINTER
+         : KIND_INVALID;
+}
+
+constexpr FormatArgKind kindAt(const char* p, size_t index);
+
+// 转换字符：p 指向长度修饰符起点
+constexpr FormatArgKind convAt(const char* p, size_t len, size_t index) {
+    return convKind(p[len], len ? p[0] : 0) == KIND_INVALID ? KIND_INVALID
+         : index == 0 ? convKind(p[len], len ? p[0] : 0)
+         : kindAt(p + len + 1, index - 1);
+}
+
+// 精度：p 指向宽度之后
+constexpr FormatArgKind precisionAt(const char* p, size_t index) {
+    return *p == '$' ? KIND_INVALID
+         : *p != '.' ? convAt(p, lengthChars(p), index)
+         : p[1] == '*' ? (index == 0 ? KIND_STAR : convAt(p + 2, lengthChars(p + 2), index - 1))
+         : convAt(skipDigits(p + 1), lengthChars(skipDigits(p + 1)), index);
+}
+
+// 宽度：p 指向标志之后
+constexpr FormatArgKind widthAt(const char* p, size_t index) {
+    return *p == '*' ? (index == 0 ? KIND_STAR : precisionAt(p + 1, index - 1))
+         : precisionAt(skipDigits(p), index);
+}
+
+// 从 p 开始查找第 index 个参数的类别
+constexpr FormatArgKind kindAt(const char* p, size_t index) {
+    return *p == '\0' ? KIND_END
+         : *p != '%' ? kindAt(p + 1, index)
+         : p[1] == '%' ? kindAt(p + 2, index)
+         : p[1] == '\0' ? KIND_INVALID
+         : widthAt(skipFlags(p + 1), index);
+}
+
+template <typename T>
+struct IsLogString : std::integral_constant<bool,
+    std::is_same<T, const char*>::value || std::is_same<T, char*>::value || std::is_same<T, std::string>::value> {};
+
+// 参数类型 T 是否可用于类别 kind
+template <typename T>
+constexpr bool argMatches(FormatArgKind kind) {
+    return (kind == KIND_SIGNED || kind == KIND_UNSIGNED || kind == KIND_CHAR || kind == KIND_STAR)
+               ? (std::is_integral<T>::value || std::is_enum<T>::value)
+         : (kind == KIND_FLOAT || kind == KIND_LONG_DOUBLE) ? std::is_floating_point<T>::value
+         : kind == KIND_STRING ? IsLogString<T>::value
+         : kind == KIND_POINTER ? (std::is_pointer<T>::value || std::is_same<T, std::nullptr_t>::value)
+         : false;
+}
+
+template <typename... Args>
+struct FormatChecker;
+
+template <>
+struct FormatChecker<> {
+    static constexpr bool check(const char* fmt, size_t index) {
+        return kindAt(fmt, index) == KIND_END;
+    }
+};
+
+template <typename T, typename... Rest>
+struct FormatChecker<T, Rest...> {
+    static constexpr bool check(const char* fmt, size_t index) {
+        return argMatches<typename std::decay<T>::type>(kindAt(fmt, index)) &&
+               FormatChecker<Rest...>::check(fmt, index + 1);
+    }
+};
+
+// 按编译期确定的类别打包单个参数
+template <FormatArgKind Kind>
+struct ArgWriter;
+
+template <>
+struct ArgWriter<KIND_SIGNED> {
+    template <typename T>
+    static void write(std::string& out, const T& value) {
+        appendPackedValue<int64_t>(out, ARG_SIGNED, static_cast<int64_t>(value));
+    }
+};
+
+template <>
+struct ArgWriter<KIND_STAR> : ArgWriter<KIND_SIGNED> {};
+
+template <>
+struct ArgWriter<KIND_UNSIGNED> {
+    template <typename T>
+    static void write(std::string& out, const T& value) {
+        appendPackedValue<uint64_t>(out, ARG_UNSIGNED, static_cast<uint64_t>(value));
+    }
+};
+
+template <>
+struct ArgWriter<KIND_FLOAT> {
+    static void write(std::string& out, double value) {
+        appendPackedValue(out, ARG_DOUBLE, value);
+    }
+};
+
+template <>
+struct ArgWriter<KIND_LONG_DOUBLE> {
+    static void write(std::string& out, long double value) {
+        appendPackedValue(out, ARG_LONG_DOUBLE, value);
+    }
+};
+
+template <>
+struct ArgWriter<KIND_CHAR> {
+    template <typename T>
+    static void write(std::string& out, const T& value) {
+        appendPackedValue<int32_t>(out, ARG_CHAR, static_cast<int32_t>(value));
+    }
+};
+
+template <>
+struct ArgWriter<KIND_STRING> {
+    static void write(std::string& out, const char* value) {
+        if (!value) value = "(null)";
+        appendPackedString(out, value, strlen(value));
+    }
+
+    static void write(std::string& out, const std::string& value) {
+        appendPackedString(out, value.data(), value.size());
+    }
+};
+
+template <>
+struct ArgWriter<KIND_POINTER> {
+    static void write(std::string& out, const void* value) {
+        appendPackedValue<uint64_t>(out, ARG_POINTER, reinterpret_cast<uintptr_t>(value));
+    }
+};
+
+} // namespace logformat
+
+// 编译期校验：格式串 fmt 与参数类型 Args 是否匹配
+template <typename... Args>
+constexpr bool logFormatMatches(const char* fmt) {
+    return logformat::FormatChecker<Args...>::check(fmt, 0);
+}
+
+// 编译期得到第 index 个参数的类别
+constexpr FormatArgKind formatArgKind(const char* fmt, size_t index) {
+    return logformat::kindAt(fmt, index);
+}
+
+// 按调用点的格式串 Fmt::str() 打包参数，每个调用点实例化出专用的打包代码
+template <typename Fmt, size_t Index>
+inline void packLogArgs(std::string&) {}
+
+template <typename Fmt, size_t Index, typename T, typename... Rest>
+inline void packLogArgs(std::string& out, const T& first, const Rest&... rest) {
+    logformat::ArgWriter<formatArgKind(Fmt::str(), Index)>::write(out, first);
+    packLogArgs<Fmt, Index + 1>(out, rest...);
+}
+
+#endif // LOG_FORMAT_H
@@ -0,0 +1,65 @@
+#include "LogLayout.h"
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+// 追加十进制整数
+void appendDecimal(std::string& out, long value) {
+    char buf[24];
+    int len = snprintf(buf, sizeof(buf), "%ld", value);
+    out.append(buf, len);
+}
+
+} // namespace
+
+const char* logLevelName(LogLevel_en level) {
+    switch (level) {
+        case DEBUG:   return "DEBUG";
+        case INFO:    return "INFO";
+        case WARNING: return "WARNING";
+        case ERROR:   return "ERROR";
+        case FATAL:   return "FATAL";
+        default:      return "UNKNOWN";
+    }
+}
+
+// 只做追加，不产生临时字符串
+void appendLogEntry(std::string& out, bool json, const char* timestamp, size_t timestampLen,
+                    LogLevel_en level, const char* file, int line, const char* message, size_t messageLen) {
+    if (!file) file = "unknown";
+
+    if (json) { // JSON 格式日志
+        out.append("{\"timestamp\":\"").append(timestamp, timestampLen);
+        out.append("\",\"level\":\"").append(logLevelName(level));
+        out.append("\",\"file\":\"").append(file);
+        out.append("\",\"line\":");
+        appendDecimal(out, line);
+        out.append(",\"message\":\"").append(message, messageLen);
+        out.append("\"}");
+    } else { // 纯文本格式日志
+        out.push_back('[');
+        out.append(timestamp, timestampLen);
+        out.append("][").append(logLevelName(level));
+        out.append("][").append(file).push_back(':');
+        appendDecimal(out, line);
+        out.append("] ").append(message, messageLen);
+    }
+}
+
+size_t logEntryBodyOffset(const char* entry, size_t len, bool json) {
+    static const char kJsonPrefix[] = "{\"timestamp\":\"";
+    size_t start;
+    char close;
+    if (json) {
+        start = sizeof(kJsonPrefix) - 1;
+        if (len < start || memcmp(entry, kJsonPrefix, start) != 0) return 0;
+        close = '"';
+    } else {
+        start = 1;
+        if (len < start || entry[0] != '[') return 0;
+        close = ']';
+    }
+    const void* end = memchr(entry + start, close, len - start);
+    return end ? static_cast<const char*>(end) - entry + 1 : 0;
+}
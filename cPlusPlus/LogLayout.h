@@ -0,0 +1,23 @@
+#ifndef LOG_LAYOUT_H
+#define LOG_LAYOUT_H
+
+#include <cstddef>
+#include <string>
+#include "LogLevel.h"
+
+// 日志行布局：Logger 与离线解码工具共用，保证两者输出一致
+
+// 日志等级名称
+const char* logLevelName(LogLevel_en level);
+
+// 按纯文本或 JSON 布局生成一条日志，追加到 out（不含换行）
+//   文本: [timestamp][LEVEL][file:line] message
+//   JSON: {"timestamp":"...","level":"...","file":"...","line":N,"message":"..."}
+void appendLogEntry(std::string& out, bool json, const char* timestamp, size_t timestampLen,
+                    LogLevel_en level, const char* file, int line, const char* message, size_t messageLen);
+
+// 跳过日志行开头的时间戳，返回其后内容的起始位置，布局无法识别时返回 0；
+// 用于判断两条已格式化的日志是否只有时间不同
+size_t logEntryBodyOffset(const char* entry, size_t len, bool json);
+
+#endif // LOG_LAYOUT_H
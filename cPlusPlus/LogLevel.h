@@ -0,0 +1,21 @@
+#ifndef LOG_LEVEL_H
+#define LOG_LEVEL_H
+
+// 日志等级枚举
+enum LogLevel_en {
+    DEBUG = 1,
+    INFO,
+    WARNING,
+    ERROR,
+    FATAL
+};
+
+// 时间精度枚举
+enum TimePrecision {
+    SECONDS,
+    MILLISECONDS,
+    MICROSECONDS,
+    NANOSECONDS
+};
+
+#endif // LOG_LEVEL_H
@@ -0,0 +1,98 @@
+#include "LogRecordPool.h"
+#include <cstddef>
+#include <cstdlib>
+
+namespace {
+
+// 单写者计数器自增
+inline void bump(std::atomic<size_t>& counter, size_t delta = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+} // namespace
+
+LogRecordPool::Slab* LogRecordPool::slabOf(char* data) {
+    return reinterpret_cast<Slab*>(data - offsetof(Slab, data));
+}
+
+char* LogRecordPool::allocate(size_t size, bool& large) {
+    if (size > kSlabSize) {
+        large = true;
+        bump(largeTaken);
+        bump(largeBytesTaken, size);
+        return static_cast<char*>(malloc(size));
+    }
+
+    large = false;
+    if (!localFree) {
+        localFree = returned.exchange(nullptr, std::memory_order_acquire);
+    }
+    if (!localFree) addChunk();
+
+    Slab* slab = localFree;
+    localFree = slab->next;
+    bump(slabsTaken);
+    return slab->data;
+}
+
+void LogRecordPool::addChunk() {
+    std::unique_ptr<Slab[]> chunk(new Slab[kSlabsPerChunk]);
+    for (size_t i = 0; i < kSlabsPerChunk; ++i) {
+        chunk[i].next = i + 1 < kSlabsPerChunk ? &chunk[i + 1] : localFree;
+    }
+    localFree = &chunk[0];
+    chunks.push_back(std::move(chunk));
+    bump(slabsAllocated, kSlabsPerChunk);
+}
+
+void LogRecordPool::releaseLocal(char* data, size_t size, bool large) {
+    if (!data) return;
+    if (large) {
+        free(data);
+        bump(largeReleasedLocal);
+        bump(largeBytesReleasedLocal, size);
+        return;
+    }
+
+    Slab* slab = slabOf(data);
+    slab->next = localFree;
+    localFree = slab;
+    bump(slabsReleasedLocal);
+}
+
+void LogRecordPool::releaseRemote(char* data, size_t size, bool large) {
+    if (!data) return;
+    if (large) {
+        free(data);
+        bump(largeReleasedRemote);
+        bump(largeBytesReleasedRemote, size);
+        return;
+    }
+
+    // 只有写线程压栈、只有生产者整体取走，不存在 ABA 问题
+    Slab* slab = slabOf(data);
+    slab->next = returned.load(std::memory_order_relaxed);
+    while (!returned.compare_exchange_weak(slab->next, slab, std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+    }
+    bump(slabsReleasedRemote);
+}
+
+// 先读归还计数再读取出计数，并发读取时占用数只会偏大、不会下溢
+LogPoolStats LogRecordPool::stats() const {
+    size_t slabsReleased = slabsReleasedLocal.load(std::memory_order_relaxed) +
+                           slabsReleasedRemote.load(std::memory_order_relaxed);
+    size_t largeReleased = largeReleasedLocal.load(std::memory_order_relaxed) +
+                           largeReleasedRemote.load(std::memory_order_relaxed);
+    size_t largeBytesReleased = largeBytesReleasedLocal.load(std::memory_order_relaxed) +
+                                largeBytesReleasedRemote.load(std::memory_order_relaxed);
+
+    LogPoolStats s;
+    s.slabSize = kSlabSize;
+    s.slabsAllocated = slabsAllocated.load(std::memory_order_relaxed);
+    s.slabsInUse = slabsTaken.load(std::memory_order_relaxed) - slabsReleased;
+    s.largeRecordsTotal = largeTaken.load(std::memory_order_relaxed);
+    s.largeRecordsInUse = s.largeRecordsTotal - largeReleased;
+    s.largeBytesInUse = largeBytesTaken.load(std::memory_order_relaxed) - largeBytesReleased;
+    return s;
+}
@@ -0,0 +1,72 @@
+#ifndef LOG_RECORD_POOL_H
+#define LOG_RECORD_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// 记录内存池统计
+struct LogPoolStats {
+    size_t slabSize = 0;                   // 单个 slab 的容量（字节）
+    size_t slabsAllocated = 0;             // 已向系统申请的 slab 数
+    size_t slabsInUse = 0;                 // 正被队列中的记录占用的 slab 数
+    size_t largeRecordsInUse = 0;          // 尚未写出的大记录数
+    size_t largeBytesInUse = 0;            // 尚未写出的大记录字节数
+    size_t largeRecordsTotal = 0;          // 累计走大记录回退路径的次数
+};
+
+// 每个生产线程一个的记录内存池：
+// 不超过 kSlabSize 的记录使用定长 slab，由生产线程从本地空闲链表取出；
+// 写线程写完后把 slab 压入无锁回收栈，生产线程在本地链表耗尽时整体取回，
+// 因此内存始终在所属线程的池内循环，不会出现跨线程 malloc/free。
+// 更大的记录退回 malloc，由写线程释放。
+class LogRecordPool {
+public:
+    static const size_t kSlabSize = 512;   // slab 数据容量
+    static const size_t kSlabsPerChunk = 64; // 每次向系统申请的 slab 数
+
+    LogRecordPool() = default;
+
+    LogRecordPool(const LogRecordPool&) = delete;
+    LogRecordPool& operator=(const LogRecordPool&) = delete;
+
+    // 生产者：分配 size 字节，large 返回是否走了大记录回退路径
+    char* allocate(size_t size, bool& large);
+
+    // 生产者：释放自己分配的存储（如溢出时丢弃最旧记录）
+    void releaseLocal(char* data, size_t size, bool large);
+
+    // 写线程：写完记录后归还存储
+    void releaseRemote(char* data, size_t size, bool large);
+
+    LogPoolStats stats() const;
+
+private:
+    struct Slab {
+        Slab* next;                        // 空闲链表指针
+        char data[kSlabSize];
+    };
+
+    static Slab* slabOf(char* data);
+    void addChunk();                       // 申请一块 slab 并挂到本地空闲链表
+
+    Slab* localFree = nullptr;             // 本地空闲链表（仅生产者访问）
+    std::atomic<Slab*> returned{nullptr};  // 写线程归还的 slab（无锁栈，生产者整体取走）
+    std::vector<std::unique_ptr<Slab[]>> chunks; // 已申请的 slab 块（仅生产者扩充，随池一起释放）
+
+    // 计数器各自只有一个写入方，用 relaxed 读写即可，不需要原子读改写
+    std::atomic<size_t> slabsAllocated{0}; // 生产者写
+    std::atomic<size_t> slabsTaken{0};     // 生产者写：累计取出的 slab
+    std::atomic<size_t> slabsReleasedLocal{0}; // 生产者写
+    std::atomic<size_t> slabsReleasedRemote{0}; // 写线程写
+    std::atomic<size_t> largeTaken{0};     // 生产者写
+    std::atomic<size_t> largeBytesTaken{0}; // 生产者写
+    std::atomic<size_t> largeReleasedLocal{0}; // 生产者写
+    std::atomic<size_t> largeBytesReleasedLocal{0}; // 生产者写
+    std::atomic<size_t> largeReleasedRemote{0}; // 写线程写
+    std::atomic<size_t> largeBytesReleasedRemote{0}; // 写线程写
+};
+
+#endif // LOG_RECORD_POOL_H
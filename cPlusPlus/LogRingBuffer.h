@@ -0,0 +1,90 @@
+#ifndef LOG_RING_BUFFER_H
+#define LOG_RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// 每线程有界无锁环形缓冲区
+// 只有所属生产线程入队；出队方可以是写线程，也可以是生产线程自己（溢出时丢弃最旧日志），
+// 因此每个槽位带序号，出队通过 CAS 认领 head，两端都不加锁、不进入内核。
+// 入队和出队都与槽位交换元素而不是移动，元素（如 std::string）的已分配容量在
+// 调用方与槽位之间循环复用，稳定状态下不产生堆分配
+template <typename T>
+class LogRingBuffer {
+public:
+    // 容量向上取整为 2 的幂，便于用掩码取模
+    explicit LogRingBuffer(size_t capacity)
+        : mask(roundUpPow2(capacity) - 1), slots(new Slot[mask + 1]) {
+        for (size_t i = 0; i <= mask; ++i) {
+            slots[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    LogRingBuffer(const LogRingBuffer&) = delete;
+    LogRingBuffer& operator=(const LogRingBuffer&) = delete;
+
+    // 生产者：把 item 换入缓冲区，item 换回槽位中的旧元素；缓冲区满时返回 false 且不修改 item
+    bool tryPush(T& item) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        Slot& slot = slots[pos & mask];
+        if (slot.seq.load(std::memory_order_acquire) != pos) return false;
+        using std::swap;
+        swap(slot.value, item);
+        slot.seq.store(pos + 1, std::memory_order_release);
+        tail.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 出队：把最旧的元素换到 out，out 原有的元素留在槽位中供之后复用；空时返回 false
+    bool tryPop(T& out) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots[pos & mask];
+            size_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq == pos + 1) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    using std::swap;
+                    swap(out, slot.value);
+                    slot.seq.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (seq == pos) {
+                return false;
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool empty() const { return size() == 0; }
+
+    size_t size() const {
+        size_t h = head.load(std::memory_order_acquire);
+        size_t t = tail.load(std::memory_order_acquire);
+        return t > h ? t - h : 0;
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> seq;           // 槽位序号：等于 pos 可写，等于 pos+1 可读
+        T value;
+    };
+
+    static size_t roundUpPow2(size_t n) {
+        size_t c = 2;
+        while (c < n) c <<= 1;
+        return c;
+    }
+
+    const size_t mask;                     // 容量掩码
+    std::unique_ptr<Slot[]> slots;         // 元素槽位
+
+    alignas(64) std::atomic<size_t> head{0}; // 出队位置
+    alignas(64) std::atomic<size_t> tail{0}; // 入队位置（仅生产者写）
+};
+
+#endif // LOG_RING_BUFFER_H
@@ -0,0 +1,284 @@
+#include "LogSink.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <climits>
+#include <cstdio>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <syslog.h>
+#include <unistd.h>
+
+LogSink::LogSink(size_t queueCapacity) : capacity(queueCapacity) {}
+
+LogSink::~LogSink() {
+    stop();
+}
+
+bool LogSink::submit(const LogSinkRecordPtr& record) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (running && queue.size() < capacity) {
+            queue.push_back(record);
+            if (queue.size() == 1) queueCV.notify_one(); // 工作线程只可能在队列为空时等待
+            return true;
+        }
+    }
+    droppedCount.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void LogSink::start() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if (running) return;
+    running = true;
+    worker = std::thread(&LogSink::workerFunc, this);
+}
+
+void LogSink::stop() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        running = false;
+    }
+    queueCV.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+// 整批取走队列，在锁外逐条输出，批末 flush 一次
+void LogSink::workerFunc() {
+    std::vector<LogSinkRecordPtr> batch;
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while (true) {
+        queueCV.wait(lock, [this] { return !queue.empty() || !running; });
+        if (queue.empty()) return;
+        batch.swap(queue);
+
+        lock.unlock();
+        for (const LogSinkRecordPtr& record : batch) write(*record);
+        flush();
+        batch.clear(); // 释放对记录的引用
+        lock.lock();
+    }
+}
+
+FileSink::FileSink(const std::string& path) {
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to open log sink file: " + path);
+    }
+}
+
+FileSink::~FileSink() {
+    stop();
+    ::close(fd);
+}
+
+void FileSink::write(const LogSinkRecord& record) {
+    pending.append(record.entry).push_back('\n');
+}
+
+void FileSink::flush() {
+    size_t offset = 0;
+    while (offset < pending.size()) {
+        ssize_t n = ::write(fd, pending.data() + offset, pending.size() - offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Log sink file write failed: " << strerror(errno) << std::endl;
+            break;
+        }
+        offset += n;
+    }
+    pending.clear();
+}
+
+ConsoleSink::ConsoleSink(int fd, ConsoleColorMode color) : fd(fd) {
+    colored = color == CONSOLE_COLOR_ALWAYS || (color == CONSOLE_COLOR_AUTO && isatty(fd));
+    struct stat st;
+    pipe = fstat(fd, &st) == 0 && (S_ISFIFO(st.st_mode) || S_ISSOCK(st.st_mode));
+}
+
+ConsoleSink::~ConsoleSink() {
+    stop();
+}
+
+void ConsoleSink::setOverflowPolicy(ConsoleOverflowPolicy policy, std::chrono::milliseconds timeout,
+                                    LogLevel_en keepLevel) {
+    overflowTimeoutMs.store(static_cast<int>(timeout.count()), std::memory_order_relaxed);
+    this->keepLevel.store(keepLevel, std::memory_order_relaxed);
+    overflowPolicy.store(policy, std::memory_order_relaxed);
+}
+
+void ConsoleSink::write(const LogSinkRecord& record) {
+    if (pending.empty() && unreported != 0) { // 上一批有丢弃，先补一行提示
+        char notice[96];
+        int len = snprintf(notice, sizeof(notice), "[logsys] console output dropped %llu log records: pipe full\n",
+                           static_cast<unsigned long long>(unreported));
+        pending.append(notice, len);
+        lines.push_back(Line{pending.size(), FATAL}); // 提示行不再丢弃
+        unreported = 0;
+    }
+
+    static const char* const kColors[] = {"\033[90m", "\033[32m", "\033[33m", "\033[31m", "\033[1;31m"};
+    if (colored && record.level >= DEBUG && record.level <= FATAL) {
+        pending.append(kColors[record.level - DEBUG]).append(record.entry).append("\033[0m\n");
+    } else {
+        pending.append(record.entry).push_back('\n');
+    }
+    lines.push_back(Line{pending.size(), record.level});
+}
+
+// 一批一次 write；管道且允许丢弃时改为可写检查加分块写
+void ConsoleSink::flush() {
+    if (pipe && overflowPolicy.load(std::memory_order_relaxed) == CONSOLE_DROP) {
+        writeWithDrop(overflowTimeoutMs.load(std::memory_order_relaxed),
+                      static_cast<LogLevel_en>(keepLevel.load(std::memory_order_relaxed)));
+    } else {
+        writeBlocking(pending.data(), pending.size());
+    }
+    pending.clear();
+    lines.clear();
+}
+
+bool ConsoleSink::waitWritable(int timeoutMs) {
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLOUT;
+    int ready;
+    do {
+        ready = poll(&pfd, 1, timeoutMs);
+    } while (ready < 0 && errno == EINTR);
+    return ready != 0; // 出错时交给 write 报告
+}
+
+void ConsoleSink::writeBlocking(const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Console log write failed: " << strerror(errno) << std::endl;
+            return;
+        }
+        data += n;
+        size -= n;
+    }
+}
+
+// 可写时写出不超过 PIPE_BUF 的一块，不会阻塞；等待超时后写完当前行，
+// 其余行中不低于 keepLevel 的阻塞写出，其他丢弃
+void ConsoleSink::writeWithDrop(int timeoutMs, LogLevel_en keepLevel) {
+    size_t offset = 0;
+    while (offset < pending.size()) {
+        if (!waitWritable(timeoutMs)) break;
+        ssize_t n = ::write(fd, pending.data() + offset, std::min<size_t>(pending.size() - offset, PIPE_BUF));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Console log write failed: " << strerror(errno) << std::endl;
+            return;
+        }
+        offset += n;
+    }
+    if (offset == pending.size()) return;
+
+    size_t next = 0;
+    while (lines[next].end <= offset) ++next;
+    std::string rest = pending.substr(offset, lines[next].end - offset);
+    uint64_t dropped = 0;
+    for (size_t i = next + 1; i < lines.size(); ++i) {
+        if (lines[i].level >= keepLevel) {
+            rest.append(pending, lines[i - 1].end, lines[i].end - lines[i - 1].end);
+        } else {
+            ++dropped;
+        }
+    }
+    writeBlocking(rest.data(), rest.size());
+    unreported += dropped;
+    pipeDroppedCount.fetch_add(dropped, std::memory_order_relaxed);
+}
+
+namespace {
+
+// openlog 的设置是进程全局的，只有最后一次 openlog 的 sink 析构时才 closelog
+std::mutex syslogOwnerMutex;
+const SyslogSink* syslogOwner = nullptr;
+
+} // namespace
+
+SyslogSink::SyslogSink(const std::string& ident, int facility) : ident(ident) {
+    std::lock_guard<std::mutex> lock(syslogOwnerMutex);
+    openlog(this->ident.c_str(), LOG_PID | LOG_NDELAY, facility);
+    syslogOwner = this;
+}
+
+SyslogSink::~SyslogSink() {
+    stop();
+    std::lock_guard<std::mutex> lock(syslogOwnerMutex);
+    if (syslogOwner == this) {
+        closelog();
+        syslogOwner = nullptr;
+    }
+}
+
+void SyslogSink::write(const LogSinkRecord& record) {
+    int priority = LOG_INFO;
+    switch (record.level) {
+        case DEBUG: priority = LOG_DEBUG; break;
+        case INFO: priority = LOG_INFO; break;
+        case WARNING: priority = LOG_WARNING; break;
+        case ERROR: priority = LOG_ERR; break;
+        case FATAL: priority = LOG_CRIT; break;
+    }
+    syslog(priority, "%s", record.message.c_str()); // 写入 syslog
+}
+
+RemoteSink::RemoteSink(const std::string& ip, uint16_t port) : ip(ip), port(port) {
+    struct sockaddr_in sa;
+    if (inet_pton(AF_INET, ip.c_str(), &(sa.sin_addr)) == 0) {
+        throw std::invalid_argument("Invalid IPv4 address: " + ip);
+    }
+}
+
+RemoteSink::~RemoteSink() {
+    stop();
+    if (sockfd != -1) ::close(sockfd); // 关闭 TCP 套接字
+}
+
+bool RemoteSink::connectServer() {
+    sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sockfd < 0) {
+        std::cerr << "Failed to create socket for remote logging" << std::endl;
+        return false;
+    }
+
+    struct sockaddr_in serverAddr;
+    memset(&serverAddr, 0, sizeof(serverAddr));
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(port);
+    inet_pton(AF_INET, ip.c_str(), &serverAddr.sin_addr);
+
+    if (connect(sockfd, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
+        std::cerr << "Failed to connect to remote server" << std::endl;
+        ::close(sockfd);
+        sockfd = -1;
+        return false;
+    }
+    return true;
+}
+
+void RemoteSink::write(const LogSinkRecord& record) {
+    if (sockfd == -1 && !connectServer()) return;
+
+    if (send(sockfd, record.entry.c_str(), record.entry.size(), MSG_DONTWAIT) == -1) {
+        std::cerr << "Remote send failed: " << strerror(errno) << std::endl;
+        ::close(sockfd);
+        sockfd = -1;
+    }
+}
+
+CallbackSink::~CallbackSink() {
+    stop();
+}
@@ -0,0 +1,181 @@
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "LogLevel.h"
+
+// 分发给各 sink 的日志：写线程只格式化一次，各 sink 通过 shared_ptr 共享同一份内容
+struct LogSinkRecord {
+    uint64_t timestamp = 0;                // 记录产生时间（自 epoch 起的纳秒数）
+    LogLevel_en level = INFO;              // 日志等级
+    std::string entry;                     // 完整日志行（文本或 JSON，不含换行）
+    std::string message;                   // 消息正文，供自带时间戳的输出（如 syslog）使用
+};
+
+typedef std::shared_ptr<const LogSinkRecord> LogSinkRecordPtr;
+
+// 日志输出目标。每个 sink 有独立的有界队列和工作线程：submit 只入队，不做 I/O，
+// 队列满时丢弃新记录并计数，慢速输出不会拖慢写线程和其他 sink。
+// 派生类实现 write，必要时实现 flush；派生类析构函数需先调用 stop()
+class LogSink {
+public:
+    explicit LogSink(size_t queueCapacity = 8192);
+    virtual ~LogSink();
+
+    // 等级过滤：低于 level 的记录不入队
+    void setLevel(LogLevel_en level) { minLevel.store(level, std::memory_order_relaxed); }
+    bool accepts(LogLevel_en level) const { return level >= minLevel.load(std::memory_order_relaxed); }
+
+    // 入队一条记录，队列满或未启动时返回 false
+    bool submit(const LogSinkRecordPtr& record);
+
+    // 启动工作线程；停止时先写完队列中剩余的记录
+    void start();
+    void stop();
+
+    // 因队列满被丢弃的记录数
+    uint64_t dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+
+protected:
+    // 工作线程调用：输出一条记录
+    virtual void write(const LogSinkRecord& record) = 0;
+
+    // 工作线程调用：一批记录输出完毕
+    virtual void flush() {}
+
+private:
+    void workerFunc();
+
+    const size_t capacity;
+    std::mutex queueMutex;
+    std::condition_variable queueCV;
+    std::vector<LogSinkRecordPtr> queue;   // 待输出的记录，工作线程整批取走
+    bool running = false;
+    std::thread worker;
+    std::atomic<int> minLevel{DEBUG};
+    std::atomic<uint64_t> droppedCount{0};
+};
+
+// 追加写入单独的文件（不滚动），例如只收集 ERROR 以上的日志
+class FileSink : public LogSink {
+public:
+    explicit FileSink(const std::string& path);
+    ~FileSink() override;
+
+protected:
+    void write(const LogSinkRecord& record) override;
+    void flush() override;
+
+private:
+    int fd = -1;
+    std::string pending;                   // 本批累积的内容，flush 时一次 write
+};
+
+// 终端输出的着色方式
+enum ConsoleColorMode {
+    CONSOLE_COLOR_AUTO,      // 描述符是终端时着色（默认）
+    CONSOLE_COLOR_ALWAYS,
+    CONSOLE_COLOR_NEVER
+};
+
+// 输出是管道且写满（读端太慢）时的处理
+enum ConsoleOverflowPolicy {
+    CONSOLE_BLOCK,           // 等待读端，积压留在 sink 队列中，队列满时丢弃新记录
+    CONSOLE_DROP             // 等待 timeout 后写完当前行，本批其余低于 keepLevel 的记录丢弃（默认）
+};
+
+// 输出到标准输出（或指定描述符）：每批记录拼成一块，用 write(2) 直接写出，不经过 std::cout。
+// 着色时按等级给整行加 ANSI 颜色。丢弃只发生在整行之间，恢复输出时先补一行丢弃条数
+class ConsoleSink : public LogSink {
+public:
+    explicit ConsoleSink(int fd = STDOUT_FILENO, ConsoleColorMode color = CONSOLE_COLOR_AUTO);
+    ~ConsoleSink() override;
+
+    void setOverflowPolicy(ConsoleOverflowPolicy policy,
+                           std::chrono::milliseconds timeout = std::chrono::milliseconds(10),
+                           LogLevel_en keepLevel = WARNING);
+
+    // 因管道写满被丢弃的记录数（不含 sink 队列满的丢弃，见 dropped()）
+    uint64_t pipeDropped() const { return pipeDroppedCount.load(std::memory_order_relaxed); }
+
+protected:
+    void write(const LogSinkRecord& record) override;
+    void flush() override;
+
+private:
+    struct Line {
+        size_t end;                        // 该行（含换行）在 pending 中的结束位置
+        LogLevel_en level;
+    };
+
+    bool waitWritable(int timeoutMs);
+    void writeBlocking(const char* data, size_t size);
+    void writeWithDrop(int timeoutMs, LogLevel_en keepLevel); // 管道按 PIPE_BUF 分块写，写满时丢弃
+
+    const int fd;
+    bool colored = false;
+    bool pipe = false;                     // 描述符是管道或套接字，可能写满
+    std::atomic<int> overflowPolicy{CONSOLE_DROP};
+    std::atomic<int> overflowTimeoutMs{10};
+    std::atomic<int> keepLevel{WARNING};
+    std::string pending;                   // 本批内容（仅工作线程访问）
+    std::vector<Line> lines;               // 本批各行
+    uint64_t unreported = 0;               // 尚未提示的丢弃条数（仅工作线程访问）
+    std::atomic<uint64_t> pipeDroppedCount{0};
+};
+
+// 输出到 syslog，等级映射为对应的 syslog 优先级
+class SyslogSink : public LogSink {
+public:
+    SyslogSink(const std::string& ident, int facility);
+    ~SyslogSink() override;
+
+protected:
+    void write(const LogSinkRecord& record) override;
+
+private:
+    std::string ident;                     // openlog 保存的是指针，需保证其生命周期
+};
+
+// 通过 TCP 发送到远程服务器，断开后在下一条记录时重连
+class RemoteSink : public LogSink {
+public:
+    RemoteSink(const std::string& ip, uint16_t port);
+    ~RemoteSink() override;
+
+protected:
+    void write(const LogSinkRecord& record) override;
+
+private:
+    bool connectServer();
+
+    std::string ip;
+    uint16_t port;
+    int sockfd = -1;
+};
+
+// 自定义输出：在 sink 的工作线程中调用回调
+class CallbackSink : public LogSink {
+public:
+    explicit CallbackSink(std::function<void(const LogSinkRecord&)> callback) : callback(std::move(callback)) {}
+    ~CallbackSink() override;
+
+protected:
+    void write(const LogSinkRecord& record) override { callback(record); }
+
+private:
+    std::function<void(const LogSinkRecord&)> callback;
+};
+
+#endif // LOG_SINK_H
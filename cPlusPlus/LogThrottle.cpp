@@ -0,0 +1,47 @@
+#include "LogThrottle.h"
+
+namespace {
+
+// 线程局部 xorshift 随机数，概率采样不需要加密强度
+uint32_t nextRandom() {
+    static thread_local uint64_t state =
+        0x9E3779B97F4A7C15ull ^ reinterpret_cast<uintptr_t>(&state);
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return static_cast<uint32_t>(state >> 32);
+}
+
+} // namespace
+
+void LogThrottle::configure(const LogThrottleConfig& config) {
+    uint64_t interval = config.ratePerSecond ? 1000000000ull / config.ratePerSecond : 0;
+    uint64_t burst = config.burst ? config.burst : config.ratePerSecond;
+    double probability = config.sampleProbability < 0 ? 0 : config.sampleProbability;
+    uint64_t threshold = probability >= 1 ? kKeepAll : static_cast<uint64_t>(probability * kKeepAll);
+
+    intervalNs.store(interval, std::memory_order_relaxed);
+    burstNs.store(interval * burst, std::memory_order_relaxed);
+    sampleEvery.store(config.sampleEvery, std::memory_order_relaxed);
+    sampleThreshold.store(threshold, std::memory_order_relaxed);
+    enabled.store(interval != 0 || config.sampleEvery > 1 || threshold < kKeepAll, std::memory_order_relaxed);
+}
+
+bool LogThrottle::admit(uint64_t nowNs, LogThrottleState& state) const {
+    uint32_t every = sampleEvery.load(std::memory_order_relaxed);
+    if (every > 1 && state.seen.fetch_add(1, std::memory_order_relaxed) % every != 0) return false;
+
+    uint64_t threshold = sampleThreshold.load(std::memory_order_relaxed);
+    if (threshold < kKeepAll && nextRandom() >= threshold) return false;
+
+    // GCRA 令牌桶：理论到达时间超前当前时间不超过桶容量时放行，一次 CAS 完成取令牌
+    uint64_t interval = intervalNs.load(std::memory_order_relaxed);
+    if (interval == 0) return true;
+    uint64_t burst = burstNs.load(std::memory_order_relaxed);
+    uint64_t tat = state.tat.load(std::memory_order_relaxed);
+    while (true) {
+        uint64_t next = (tat > nowNs ? tat : nowNs) + interval;
+        if (next - nowNs > burst) return false;
+        if (state.tat.compare_exchange_weak(tat, next, std::memory_order_relaxed)) return true;
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef LOG_THROTTLE_H
+#define LOG_THROTTLE_H
+
+#include <atomic>
+#include <cstdint>
+
+// 限流与采样配置，各项可以组合，按 1-in-N 采样、概率采样、令牌桶的顺序检查
+struct LogThrottleConfig {
+    uint32_t ratePerSecond = 0;            // 令牌桶速率（条/秒），0 表示不限流
+    uint32_t burst = 0;                    // 桶容量（允许的突发条数），0 时等于 ratePerSecond
+    uint32_t sampleEvery = 0;              // 每 N 条保留 1 条，0 或 1 表示不做 1-in-N 采样
+    double sampleProbability = 1.0;        // 每条被保留的概率，1 表示不做概率采样
+};
+
+// 调用点上的限流状态，由共享该调用点的所有线程以原子操作更新
+struct LogThrottleState {
+    std::atomic<uint64_t> tat{0};          // 令牌桶（GCRA）的理论到达时间（纳秒）
+    std::atomic<uint64_t> seen{0};         // 1-in-N 采样计数
+};
+
+// 限流器：配置可随时修改，检查无锁，在格式化之前进行
+class LogThrottle {
+public:
+    void configure(const LogThrottleConfig& config);
+
+    // 是否配置了任何限流或采样
+    bool active() const { return enabled.load(std::memory_order_relaxed); }
+
+    // 判断时间 nowNs 的一条记录是否保留，state 为该调用点的限流状态
+    bool admit(uint64_t nowNs, LogThrottleState& state) const;
+
+private:
+    static const uint64_t kKeepAll = uint64_t(1) << 32; // 概率阈值：随机数 < 阈值时保留
+
+    std::atomic<bool> enabled{false};
+    std::atomic<uint64_t> intervalNs{0};   // 每个令牌的间隔，0 表示不限流
+    std::atomic<uint64_t> burstNs{0};      // 桶容量对应的时间
+    std::atomic<uint32_t> sampleEvery{0};
+    std::atomic<uint64_t> sampleThreshold{kKeepAll};
+};
+
+#endif // LOG_THROTTLE_H
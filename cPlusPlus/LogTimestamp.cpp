@@ -0,0 +1,155 @@
+#include "LogTimestamp.h"
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define LOGSYS_HAS_TSC 1
+#else
+#define LOGSYS_HAS_TSC 0
+#endif
+
+namespace {
+
+// 写入定长的零填充十进制数
+inline void writeDigits(char* out, uint64_t value, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+inline uint64_t readTsc() {
+#if LOGSYS_HAS_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// CPUID 0x80000007 EDX bit 8：TSC 频率恒定且不随 C/P 状态停止
+bool hasInvariantTsc() {
+#if LOGSYS_HAS_TSC
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007) return false;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) return false;
+    return (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+uint64_t systemClockNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+size_t TimestampCache::format(uint64_t ns, TimePrecision precision, char* out) {
+    int64_t second = static_cast<int64_t>(ns / 1000000000ULL);
+    if (second != cachedSecond) {
+        time_t t = static_cast<time_t>(second);
+        std::tm local;
+        localtime_r(&t, &local);
+        strftime(prefix, sizeof(prefix), "%Y-%m-%d %H:%M:%S", &local);
+        cachedSecond = second;
+    }
+    memcpy(out, prefix, 19);
+
+    uint64_t subsecond = ns % 1000000000ULL;
+    size_t len = 19;
+    switch (precision) {
+        case SECONDS:
+            break;
+        case MILLISECONDS:
+            out[len++] = '.';
+            writeDigits(out + len, subsecond / 1000000, 3);
+            len += 3;
+            break;
+        case MICROSECONDS:
+            out[len++] = '.';
+            writeDigits(out + len, subsecond / 1000, 6);
+            len += 6;
+            break;
+        case NANOSECONDS:
+            out[len++] = '.';
+            writeDigits(out + len, subsecond, 9);
+            len += 9;
+            break;
+    }
+    out[len] = '\0';
+    return len;
+}
+
+std::string TimestampCache::format(uint64_t ns, TimePrecision precision) {
+    char buf[kMaxLength];
+    size_t len = format(ns, precision, buf);
+    return std::string(buf, len);
+}
+
+TscClock& TscClock::instance() {
+    static TscClock clock;
+    return clock;
+}
+
+// 构造时做一次约 10ms 的短校准，之后由 resync 逐步修正
+TscClock::TscClock() {
+    supported = hasInvariantTsc();
+    if (!supported) return;
+
+    calibrationTsc = readTsc();
+    calibrationNs = systemClockNowNs();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    uint64_t tsc = readTsc();
+    uint64_t ns = systemClockNowNs();
+    if (tsc <= calibrationTsc) {
+        supported = false;
+        return;
+    }
+
+    nsPerTick.store(static_cast<double>(ns - calibrationNs) / static_cast<double>(tsc - calibrationTsc));
+    baseTsc.store(tsc);
+    baseNs.store(ns);
+}
+
+uint64_t TscClock::nowNs() const {
+    if (!supported) return systemClockNowNs();
+
+    uint64_t tscBase, nsBase;
+    double ratio;
+    uint32_t before, after;
+    do {
+        before = seq.load(std::memory_order_acquire);
+        tscBase = baseTsc.load(std::memory_order_relaxed);
+        nsBase = baseNs.load(std::memory_order_relaxed);
+        ratio = nsPerTick.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = seq.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    uint64_t tsc = readTsc();
+    if (tsc < tscBase) return nsBase;
+    return nsBase + static_cast<uint64_t>(static_cast<double>(tsc - tscBase) * ratio);
+}
+
+void TscClock::resync() {
+    if (!supported) return;
+
+    std::lock_guard<std::mutex> lock(resyncMutex);
+    uint64_t tsc = readTsc();
+    uint64_t ns = systemClockNowNs();
+    if (tsc <= calibrationTsc || ns <= calibrationNs) return;
+
+    // 用自校准起点以来的长区间修正频率，区间越长越准
+    double ratio = static_cast<double>(ns - calibrationNs) / static_cast<double>(tsc - calibrationTsc);
+
+    seq.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    baseTsc.store(tsc, std::memory_order_relaxed);
+    baseNs.store(ns, std::memory_order_relaxed);
+    nsPerTick.store(ratio, std::memory_order_relaxed);
+    seq.fetch_add(1, std::memory_order_release);
+}
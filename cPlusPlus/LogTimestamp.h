@@ -0,0 +1,73 @@
+#ifndef LOG_TIMESTAMP_H
+#define LOG_TIMESTAMP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include "LogLevel.h"
+
+// 时间戳时钟源
+enum TimestampClock {
+    SYSTEM_CLOCK,        // std::chrono::system_clock（clock_gettime vDSO）
+    TSC_CLOCK            // 校准后的 CPU 时间戳计数器，不支持时退回 SYSTEM_CLOCK
+};
+
+// 时间戳格式化缓存：每秒只调用一次 localtime_r 生成 "YYYY-mm-dd HH:MM:SS" 前缀，
+// 之后只追加亚秒部分。非线程安全，每个线程各持有一份
+class TimestampCache {
+public:
+    static const size_t kMaxLength = 30;   // 最长输出（纳秒精度 29 字节 + '\0'）
+
+    // 把自 epoch 起的纳秒数格式化到 out（至少 kMaxLength 字节），返回长度（不含 '\0'）
+    size_t format(uint64_t ns, TimePrecision precision, char* out);
+
+    std::string format(uint64_t ns, TimePrecision precision);
+
+private:
+    int64_t cachedSecond = -1;             // 前缀对应的秒
+    char prefix[20];                       // 缓存的 "YYYY-mm-dd HH:MM:SS"
+};
+
+// 校准后的 TSC 时钟：rdtsc 读数按校准比例换算为自 epoch 起的纳秒数
+class TscClock {
+public:
+    static TscClock& instance();
+
+    TscClock(const TscClock&) = delete;
+    TscClock& operator=(const TscClock&) = delete;
+
+    // 当前 CPU 是否支持恒定速率的 TSC
+    bool available() const { return supported; }
+
+    // 当前时间（纳秒）；不支持 TSC 时返回 system_clock 时间
+    uint64_t nowNs() const;
+
+    // 与 system_clock 重新对齐并修正频率，应由后台线程周期性调用
+    void resync();
+
+private:
+    TscClock();
+
+    bool supported = false;
+    std::atomic<uint32_t> seq{0};          // 顺序锁，保护下面三个参数
+    std::atomic<uint64_t> baseTsc{0};      // 对齐点的 TSC 读数
+    std::atomic<uint64_t> baseNs{0};       // 对齐点的 system_clock 纳秒数
+    std::atomic<double> nsPerTick{1.0};    // 每个 TSC 周期的纳秒数
+
+    std::mutex resyncMutex;                // 串行化 resync
+    uint64_t calibrationTsc = 0;           // 校准起点的 TSC 读数
+    uint64_t calibrationNs = 0;            // 校准起点的 system_clock 纳秒数
+};
+
+// 系统时钟的当前时间（纳秒）
+uint64_t systemClockNowNs();
+
+// 按时钟源取当前时间（纳秒）
+inline uint64_t timestampNowNs(TimestampClock clock) {
+    return clock == TSC_CLOCK ? TscClock::instance().nowNs() : systemClockNowNs();
+}
+
+#endif // LOG_TIMESTAMP_H
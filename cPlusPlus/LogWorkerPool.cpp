@@ -0,0 +1,167 @@
+#include "LogWorkerPool.h"
+#include <algorithm>
+#include <chrono>
+
+LogWorkerPool& LogWorkerPool::instance() {
+    static LogWorkerPool pool;
+    return pool;
+}
+
+LogWorkerPool::LogWorkerPool() {
+    taskThread.thread = std::thread(&LogWorkerPool::taskFunc, std::ref(taskThread));
+    ioThread.thread = std::thread(&LogWorkerPool::taskFunc, std::ref(ioThread));
+}
+
+LogWorkerPool::~LogWorkerPool() {
+    for (auto& writer : writers) {
+        {
+            std::lock_guard<std::mutex> lock(writer->mutex);
+            writer->stopping = true;
+        }
+        writer->cv.notify_all();
+        if (writer->thread.joinable()) writer->thread.join();
+    }
+    stopTaskThread(taskThread); // 任务可能等待 I/O，先停任务线程
+    stopTaskThread(ioThread);
+}
+
+void LogWorkerPool::setWriterThreads(size_t count) {
+    std::lock_guard<std::mutex> lock(writersMutex);
+    maxWriters = std::max<size_t>(count, 1);
+}
+
+// 已有线程都在服务实例且数量未达上限时新开一个，否则选实例最少的线程
+size_t LogWorkerPool::attach(LogPollable* client) {
+    std::lock_guard<std::mutex> lock(writersMutex);
+    size_t best = writers.size();
+    size_t bestLoad = 0;
+    for (size_t i = 0; i < writers.size(); ++i) {
+        std::lock_guard<std::mutex> writerLock(writers[i]->mutex);
+        if (best == writers.size() || writers[i]->clients.size() < bestLoad) {
+            best = i;
+            bestLoad = writers[i]->clients.size();
+        }
+    }
+    if (best == writers.size() || (bestLoad > 0 && writers.size() < maxWriters)) {
+        writers.emplace_back(new Writer);
+        best = writers.size() - 1;
+        Writer& writer = *writers.back();
+        writer.thread = std::thread(&LogWorkerPool::writerFunc, this, std::ref(writer));
+    }
+
+    Writer& writer = *writers[best];
+    {
+        std::lock_guard<std::mutex> writerLock(writer.mutex);
+        writer.clients.push_back(client);
+        writer.wakeup = true;
+    }
+    writer.cv.notify_all();
+    return best;
+}
+
+void LogWorkerPool::detach(LogPollable* client, size_t index) {
+    Writer* writer;
+    {
+        std::lock_guard<std::mutex> lock(writersMutex);
+        writer = writers[index].get();
+    }
+    {
+        std::lock_guard<std::mutex> lock(writer->mutex);
+        writer->clients.erase(std::remove(writer->clients.begin(), writer->clients.end(), client),
+                              writer->clients.end());
+    }
+    // 之后开始的轮询已看不到 client，只需等待正在进行的一轮结束
+    std::lock_guard<std::mutex> pollLock(writer->pollMutex);
+}
+
+void LogWorkerPool::wake(size_t index) {
+    Writer* writer;
+    {
+        std::lock_guard<std::mutex> lock(writersMutex);
+        writer = writers[index].get();
+    }
+    {
+        std::lock_guard<std::mutex> lock(writer->mutex);
+        writer->wakeup = true;
+    }
+    writer->cv.notify_all();
+}
+
+void LogWorkerPool::post(std::function<void()> task) {
+    enqueue(taskThread, std::move(task));
+}
+
+void LogWorkerPool::postIo(std::function<void()> task) {
+    enqueue(ioThread, std::move(task));
+}
+
+void LogWorkerPool::enqueue(TaskThread& thread, std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(thread.mutex);
+        if (!thread.stopping) {
+            thread.tasks.push(std::move(task));
+            thread.cv.notify_one();
+            return;
+        }
+    }
+    task();
+}
+
+// 执行完已提交的任务后退出
+void LogWorkerPool::stopTaskThread(TaskThread& thread) {
+    {
+        std::lock_guard<std::mutex> lock(thread.mutex);
+        thread.stopping = true;
+    }
+    thread.cv.notify_all();
+    if (thread.thread.joinable()) thread.thread.join();
+}
+
+// 有进展时立即开始下一轮，全部空闲时从 50us 起指数退避到 5ms
+void LogWorkerPool::writerFunc(Writer& writer) {
+    const auto minIdleWait = std::chrono::microseconds(50);
+    const auto maxIdleWait = std::chrono::microseconds(5000);
+    auto idleWait = minIdleWait;
+    std::vector<LogPollable*> clients;
+
+    while (true) {
+        bool progress = false;
+        {
+            std::lock_guard<std::mutex> pollLock(writer.pollMutex);
+            {
+                std::lock_guard<std::mutex> lock(writer.mutex);
+                if (writer.stopping) return;
+                clients = writer.clients;
+            }
+            for (LogPollable* client : clients) {
+                if (client->poll()) progress = true;
+            }
+        }
+        if (progress) {
+            idleWait = minIdleWait;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(writer.mutex);
+        writer.cv.wait_for(lock, idleWait, [&writer] { return writer.wakeup || writer.stopping; });
+        if (writer.wakeup) {
+            writer.wakeup = false;
+            idleWait = minIdleWait; // 有生产者在等待落盘
+        } else {
+            idleWait = std::min(idleWait * 2, maxIdleWait);
+        }
+    }
+}
+
+void LogWorkerPool::taskFunc(TaskThread& thread) {
+    std::unique_lock<std::mutex> lock(thread.mutex);
+    while (true) {
+        thread.cv.wait(lock, [&thread] { return !thread.tasks.empty() || thread.stopping; });
+        if (thread.tasks.empty()) return;
+        std::function<void()> task = std::move(thread.tasks.front());
+        thread.tasks.pop();
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef LOG_WORKER_POOL_H
+#define LOG_WORKER_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// 由写线程轮询的对象
+class LogPollable {
+public:
+    virtual ~LogPollable() {}
+
+    // 处理一轮积压的工作，返回是否有进展；所在线程的全部对象都没有进展时退避休眠
+    virtual bool poll() = 0;
+};
+
+// 各日志实例共享的后台线程：少量写线程轮流轮询挂在其上的实例；一个任务线程执行滚动收尾、
+// 预开下一段、压缩等后台任务；一个 I/O 线程替写入后端执行批量写出。
+// 任务可能等待 I/O 完成（如关闭旧段），因此两者分开。
+// 写线程按需启动，实例数超过写线程数时挂到负载最轻的线程上
+class LogWorkerPool {
+public:
+    static LogWorkerPool& instance();
+    ~LogWorkerPool();
+
+    // 写线程数上限（默认 2），只影响之后的 attach
+    void setWriterThreads(size_t count);
+
+    // 挂到一个写线程上，返回写线程编号
+    size_t attach(LogPollable* client);
+
+    // 从写线程上摘下，返回后 client 不会再被轮询
+    void detach(LogPollable* client, size_t writer);
+
+    // 结束写线程的退避休眠
+    void wake(size_t writer);
+
+    // 在任务线程 / I/O 线程上执行；线程池已停止时（进程退出阶段）直接执行
+    void post(std::function<void()> task);
+    void postIo(std::function<void()> task);
+
+private:
+    LogWorkerPool();
+
+    // 按提交顺序执行任务的单个线程
+    struct TaskThread {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::queue<std::function<void()>> tasks;
+        bool stopping = false;
+        std::thread thread;
+    };
+
+    struct Writer {
+        std::mutex mutex;                  // 保护 clients、wakeup、stopping
+        std::condition_variable cv;
+        std::vector<LogPollable*> clients;
+        bool wakeup = false;
+        bool stopping = false;
+        std::mutex pollMutex;              // 一轮轮询期间持有，detach 借此等待当前一轮结束
+        std::thread thread;
+    };
+
+    void writerFunc(Writer& writer);
+    static void taskFunc(TaskThread& thread);
+    static void enqueue(TaskThread& thread, std::function<void()> task);
+    static void stopTaskThread(TaskThread& thread);
+
+    std::mutex writersMutex;               // 保护 writers 与 maxWriters
+    std::vector<std::unique_ptr<Writer>> writers;
+    size_t maxWriters = 2;
+
+    TaskThread taskThread;                 // 后台任务
+    TaskThread ioThread;                   // 写入后端的 I/O
+};
+
+#endif // LOG_WORKER_POOL_H
@@ -1,9 +1,61 @@
 #include "Logger3.h"
+#include <algorithm>
 #include <cstdarg>
 #include <cstdio>
 #include <cstdlib>
+#include <map>
 #include <sys/file.h> // 文件锁
 
+namespace {
+
+// 实例编号生成器
+uint64_t nextLoggerInstanceId() {
+    static std::atomic<uint64_t> counter{0};
+    return ++counter;
+}
+
+// 线程局部的缓冲区表：线程退出时把自己的缓冲区标记为已废弃，由写线程排空后回收。
+// 缓冲区归实例所有，表中只持有弱引用，实例销毁后缓冲区随之释放，失效的表项在下次新建缓冲区时清理
+struct ThreadBufferTable {
+    struct Entry {
+        uint64_t instanceId;
+        ThreadLogBuffer* buffer;           // 热路径直接使用：实例存活期间缓冲区不会被回收
+        std::weak_ptr<ThreadLogBuffer> owner;
+    };
+    std::vector<Entry> entries;
+
+    ~ThreadBufferTable() {
+        for (auto& entry : entries) {
+            if (auto buffer = entry.owner.lock()) buffer->abandoned.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadBufferTable threadBufferTable;
+
+// 线程局部的格式化缓冲区：调用线程上的记录构造全部在这里完成，稳定状态下不分配堆内存
+struct ThreadFormatBuffers {
+    std::string payload;                   // 记录内容，随后拷入记录池
+    char message[4096];                    // 消息正文
+    std::string largeMessage;              // 超出定长缓冲区的消息
+};
+
+thread_local ThreadFormatBuffers formatBuffers;
+
+// 命名实例登记表
+struct LoggerRegistry {
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<Logger>> loggers;
+};
+
+LoggerRegistry& loggerRegistry() {
+    LogWorkerPool::instance(); // 先于登记表构造线程池，保证实例析构时仍可用
+    static LoggerRegistry registry;
+    return registry;
+}
+
+} // namespace
+
 // 构造函数
 // Logger::Logger(const std::string& path, const std::string& name, size_t maxFileSize, size_t maxFileCount)
 //     : logPath(path), logName(name), maxFileSize(maxFileSize), maxFileCount(maxFileCount), running(true) {
@@ -26,49 +78,60 @@
 
 // 构造函数
 Logger::Logger(const std::string& path, const std::string& name, size_t maxFileSize, size_t maxFileCount)
-    : logPath(path), logName(name), maxFileSize(maxFileSize), maxFileCount(maxFileCount), running(true) {
+    : logPath(path), logName(name), maxFileSize(maxFileSize), maxFileCount(maxFileCount), running(true),
+      instanceId(nextLoggerInstanceId()) {
     if (maxFileCount < 1) {
         throw std::invalid_argument("maxFileCount must be at least 1");
     }
 
-    checkAndCreateLogDirectory(); // 检查并创建日志目录
-    currentFilePath = logPath / (logName + "_1.log"); // 当前日志文件路径
+    LogCallSiteRegistry::instance(); // 先于本实例构造调用点表，保证析构时仍可用
+    LogWorkerPool::instance();       // 同上，线程池须在所有实例析构之后才停止
+
+    checkAndCreateLogDirectory(); // 检查并创建日志目录，确定当前段
 
     // 添加调试信息
     if (!fs::exists(currentFilePath)) {
         std::cerr << "Warning: Current log file does not exist on creation: " << currentFilePath.string() << std::endl;
     }
 
-    outFile.open(currentFilePath, std::ios::app); // 打开日志文件
-    if (!outFile) {
+    fileWriter.reset(new WritevFileWriter);
+    if (!fileWriter->open(currentFilePath.string())) { // 打开日志文件
         throw std::runtime_error("Failed to open log file: " + currentFilePath.string());
     }
+    segmentBytes = openedFileSize(*fileWriter, currentFilePath);
+    prepareNextSegment(); // 在共享的后台任务线程上执行
 
-    writeThread = std::thread(&Logger::writeThreadFunc, this); // 启动日志写入线程
-    compressThread = std::thread(&Logger::compressThreadFunc, this); // 启动压缩线程
-    remoteThread = std::thread(&Logger::remoteThreadFunc, this); // 启动远程日志线程
+    writerIndex = LogWorkerPool::instance().attach(this); // 挂到共享写线程上
 }
 
 // 析构函数
 Logger::~Logger() {
     running = false;
-    compressRunning = false;
-    remoteRunning = false;
-    cv.notify_all();
-    compressCV.notify_all();
-
-    if (writeThread.joinable()) writeThread.join();
-    if (compressThread.joinable()) compressThread.join();
-    if (remoteThread.joinable()) remoteThread.join();
+    LogWorkerPool::instance().detach(this, writerIndex); // 返回后写线程不再访问本实例
+    applyLogLocation();
 
     // 处理剩余日志
-    while (!logQueue.empty()) {
-        writeToFile(logQueue.front());
-        logQueue.pop();
+    while (drainBuffers()) {
+    }
+    flushRepeats();
+    commitBatch();
+    if (durability.load() != DURABILITY_NONE) syncToDisk();
+    reportDrops(true);
+    reportSuppressed(true);
+
+    // 等待滚动留下的关闭、预开等后台任务执行完
+    {
+        std::unique_lock<std::mutex> lock(backgroundMutex);
+        backgroundCV.wait(lock, [this] { return backgroundPending == 0; });
     }
+    fileWriter->close(); // 提交最后一批
+    discardNextSegment();
 
-    if (sockfd != -1) close(sockfd); // 关闭 TCP 套接字
-    if (useSyslog) closelog(); // 关闭 syslog
+    if (spillFd != -1) close(spillFd); // 关闭溢出文件
+
+    // 各 sink 输出完队列中剩余的记录
+    std::lock_guard<std::mutex> lock(sinksMutex);
+    for (auto& sink : sinks) sink->stop();
 }
 
 // 获取单例实例
@@ -77,6 +140,68 @@ Logger& Logger::getInstance(const std::string& path, const std::string& name, si
     return instance;
 }
 
+Logger& Logger::create(const std::string& instanceName, const std::string& path, const std::string& name,
+                       size_t maxFileSize, size_t maxFileCount) {
+    LoggerRegistry& registry = loggerRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::unique_ptr<Logger>& slot = registry.loggers[instanceName];
+    if (slot) throw std::invalid_argument("Logger instance already exists: " + instanceName);
+    try {
+        slot.reset(new Logger(path, name, maxFileSize, maxFileCount));
+    } catch (...) {
+        registry.loggers.erase(instanceName);
+        throw;
+    }
+    return *slot;
+}
+
+Logger* Logger::find(const std::string& instanceName) {
+    LoggerRegistry& registry = loggerRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto it = registry.loggers.find(instanceName);
+    return it == registry.loggers.end() ? nullptr : it->second.get();
+}
+
+bool Logger::destroy(const std::string& instanceName) {
+    std::unique_ptr<Logger> logger;
+    {
+        LoggerRegistry& registry = loggerRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        auto it = registry.loggers.find(instanceName);
+        if (it == registry.loggers.end()) return false;
+        logger = std::move(it->second);
+        registry.loggers.erase(it);
+    }
+    return true; // 在登记表锁外析构，写完剩余日志
+}
+
+
+// 解析 <logName>.<序号>.log 或 <logName>.<周期>.<序号>.log，返回序号，不匹配返回 0
+static uint64_t parseSegmentName(const std::string& fileName, const std::string& logName, std::string* tag) {
+    static const char kSuffix[] = ".log";
+    const size_t suffixLen = sizeof(kSuffix) - 1;
+    if (fileName.size() <= logName.size() + 1 + suffixLen || fileName.compare(0, logName.size(), logName) != 0 ||
+        fileName[logName.size()] != '.' ||
+        fileName.compare(fileName.size() - suffixLen, suffixLen, kSuffix) != 0) {
+        return 0;
+    }
+    size_t begin = logName.size() + 1;
+    size_t end = fileName.size() - suffixLen;
+    size_t sequenceBegin = fileName.rfind('.', end - 1) + 1; // 不小于 begin
+    auto digits = [&fileName](size_t from, size_t to) {
+        if (from >= to) return false;
+        for (size_t i = from; i < to; ++i) {
+            if (fileName[i] < '0' || fileName[i] > '9') return false;
+        }
+        return true;
+    };
+    if (!digits(sequenceBegin, end) || (sequenceBegin != begin && !digits(begin, sequenceBegin - 1))) return 0;
+
+    uint64_t sequence = 0;
+    for (size_t i = sequenceBegin; i < end; ++i) sequence = sequence * 10 + (fileName[i] - '0');
+    if (tag) tag->assign(fileName, begin, sequenceBegin == begin ? 0 : sequenceBegin - 1 - begin);
+    return sequence;
+}
 
 void Logger::checkAndCreateLogDirectory() {
     std::error_code ec;
@@ -88,7 +213,17 @@ void Logger::checkAndCreateLogDirectory() {
         throw std::runtime_error("Error accessing log directory: " + logPath.string());
     }
 
-    currentFilePath = logPath / (logName + "_1.log");
+    // 从编号最大的段继续写入，沿用它的周期标记
+    scanSegments();
+    if (segmentFiles.empty()) {
+        currentSegment = 1;
+        periodTag.clear();
+        segmentFiles.push_back(segmentPath(currentSegment));
+    } else {
+        currentSegment = parseSegmentName(segmentFiles.back().filename().string(), logName, &periodTag);
+    }
+    currentFilePath = segmentFiles.back();
+    nextRotationNs.store(0); // 下一条记录重新确定周期
     if (!fs::exists(currentFilePath)) {
         std::ofstream file(currentFilePath);
         if (!file) {
@@ -96,73 +231,575 @@ void Logger::checkAndCreateLogDirectory() {
         }
         file.close();
     }
+    updateActiveLink(activeLinkPath(), currentFilePath);
+}
+
+// 段文件名：<logName>[.<周期>].<序号>.log，序号单调递增，至少 6 位
+fs::path Logger::segmentPath(uint64_t sequence) const {
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%06llu.log", static_cast<unsigned long long>(sequence));
+    return logPath / (periodTag.empty() ? logName + suffix : logName + "." + periodTag + suffix);
+}
+
+// 只在打开日志目录时扫描一次，之后由滚动维护 segmentFiles，不再访问目录
+void Logger::scanSegments() {
+    std::vector<std::pair<uint64_t, fs::path>> found;
+    std::error_code ec;
+    for (fs::directory_iterator it(logPath, ec), end; !ec && it != end; it.increment(ec)) {
+        uint64_t sequence = parseSegmentName(it->path().filename().string(), logName, nullptr);
+        if (sequence != 0) found.emplace_back(sequence, it->path());
+    }
+    std::sort(found.begin(), found.end());
+    segmentFiles.clear();
+    for (auto& segment : found) segmentFiles.push_back(segment.second);
+}
+
+fs::path Logger::activeLinkPath() const {
+    return logPath / (logName + ".log");
+}
+
+// 符号链接指向当前段：先建临时链接再 rename 覆盖，读者不会看到链接缺失
+void Logger::updateActiveLink(const fs::path& link, const fs::path& segment) {
+    fs::path temp = link.string() + ".tmp";
+    std::string target = segment.filename().string();
+    ::unlink(temp.c_str());
+    if (::symlink(target.c_str(), temp.c_str()) != 0 || ::rename(temp.c_str(), link.c_str()) != 0) {
+        std::cerr << "Failed to update active log link " << link << ": " << strerror(errno) << std::endl;
+    }
+}
+
+// 删除超出保留数量的旧段（调整 maxFileCount 时使用）
+void Logger::pruneSegments() {
+    while (segmentFiles.size() > maxFileCount) {
+        std::error_code ec;
+        fs::remove(segmentFiles.front(), ec);
+        segmentFiles.pop_front();
+    }
 }
 // 日志记录方法
 void Logger::log(LogLevel_en level, const std::string& format, const char* file, int line, ...) {
-    if (!logLevelEnabled.test(level - 1)) return; // 如果该日志等级未启用，直接返回
-
     va_list args;
     va_start(args, line);
-    int len = vsnprintf(nullptr, 0, format.c_str(), args);
+    vlog(level, format.c_str(), file, line, args);
     va_end(args);
-    std::vector<char> buffer(len + 1);
+}
+
+void Logger::log(LogLevel_en level, const char* format, const char* file, int line, ...) {
+    va_list args;
     va_start(args, line);
-    vsnprintf(buffer.data(), buffer.size(), format.c_str(), args);
+    vlog(level, format, file, line, args);
+    va_end(args);
+}
+
+void Logger::log(const LogCallSite* site, ...) {
+    va_list args;
+    va_start(args, site);
+    vlog(site->level, site->format.c_str(), site->file, site->line, args, site);
     va_end(args);
-    std::string message(buffer.data());
-
-    std::ostringstream logEntry;
-    if (jsonFormat) { // JSON 格式日志
-        logEntry << "{"
-                 << "\"timestamp\":\"" << getCurrentTimeString() << "\","
-                 << "\"level\":\"" << getLogLevelString(level) << "\","
-                 << "\"file\":\"" << (file ? file : "unknown") << "\","
-                 << "\"line\":" << line << ","
-                 << "\"message\":\"" << message << "\""
-                 << "}";
-    } else { // 纯文本格式日志
-        logEntry << "[" << getCurrentTimeString() << "]"
-                 << "[" << getLogLevelString(level) << "]"
-                 << "[" << (file ? file : "unknown") << ":" << line << "] "
-                 << message;
+}
+
+void Logger::log(const LogCategory& category, const LogCallSite* site, ...) {
+    va_list args;
+    va_start(args, site);
+    vlog(site->level, site->format.c_str(), site->file, site->line, args, site, &category);
+    va_end(args);
+}
+
+// 变参日志记录的公共实现：记录在线程局部缓冲区中一次格式化完成，再与槽位交换入队
+void Logger::vlog(LogLevel_en level, const char* format, const char* file, int line, va_list args,
+                  const LogCallSite* site, const LogCategory* category) {
+    bool enabled = category ? isEnabled(*site, *category) : site ? isEnabled(*site) : isLevelEnabled(level);
+    if (!enabled) return; // 如果该日志等级未启用，直接返回
+
+    LogRecord record;
+    record.timestamp = timestampNowNs(static_cast<TimestampClock>(timestampClock.load(std::memory_order_relaxed)));
+    record.level = level;
+
+    // 只有经宏登记的调用点的文件名和格式串是字面量，可以由写线程按编号延迟格式化
+    const bool literalSite = site != nullptr;
+
+    // 配置了限流或采样时需要调用点来保存限流状态，未经宏登记的调用在此查表。
+    // 只按文件、行号和等级登记，运行期拼出的格式串不进入调用点表
+    if (!site && (levelThrottles[level - 1].active() || LogCallSiteRegistry::instance().hasThrottleRules())) {
+        site = &LogCallSiteRegistry::instance().registerSite(file, line, nullptr, level, "");
+    }
+    if (site && !admitRecord(*site, record.timestamp)) return;
+    record.callSiteId = site ? site->id : 0;
+    std::string& payload = formatBuffers.payload;
+    payload.clear();
+
+    if (literalSite &&
+        (deferredFormatting.load(std::memory_order_relaxed) || binaryFormat.load(std::memory_order_relaxed))) {
+        // 延迟格式化：只拷贝调用点编号和原始参数，格式化交给写线程
+        if (record.callSiteId != 0 && packPrintfArgs(format, args, payload)) {
+            record.formatted = false;
+            submitRecord(record, payload);
+            return;
+        }
+        payload.clear(); // 格式串含不支持的转换，退回立即格式化
     }
 
-    std::lock_guard<std::mutex> lock(mutex);
-    if (logQueue.size() >= maxQueueSize) {
-        logQueue.pop(); // 丢弃最旧日志
+    // 只做一次 vsnprintf，超出定长缓冲区时才扩容重试
+    va_list copy;
+    va_copy(copy, args);
+    int len = vsnprintf(formatBuffers.message, sizeof(formatBuffers.message), format, copy);
+    va_end(copy);
+    const char* message = formatBuffers.message;
+    if (len < 0) {
+        len = 0;
+        formatBuffers.message[0] = '\0';
+    } else if (static_cast<size_t>(len) >= sizeof(formatBuffers.message)) {
+        formatBuffers.largeMessage.resize(len + 1);
+        va_copy(copy, args);
+        vsnprintf(&formatBuffers.largeMessage[0], len + 1, format, copy);
+        va_end(copy);
+        message = formatBuffers.largeMessage.c_str();
     }
-    logQueue.push(logEntry.str()); // 将日志消息加入队列
-    cv.notify_one(); // 通知写线程
 
-    if (outputToConsole) { // 输出到终端
-        std::cout << logEntry.str() << std::endl;
+    formatEntry(payload, level, file, line, record.timestamp, message, len);
+    submitRecord(record, payload);
+}
+
+std::string& Logger::pendingPayload() {
+    return formatBuffers.payload;
+}
+
+// 内容拷入本线程的记录池后放入环形缓冲区：无锁、无系统调用，写线程轮询排空
+void Logger::submitRecord(LogRecord& record, const std::string& payload) {
+    ThreadLogBuffer& threadBuffer = localBuffer();
+    record.data = threadBuffer.pool.allocate(payload.size(), record.large);
+    if (!record.data) {
+        countDropped(record);
+        return;
     }
+    memcpy(record.data, payload.data(), payload.size());
+    record.size = static_cast<uint32_t>(payload.size());
 
-    if (useSyslog && syslogLevel <= level) { // 输出到 syslog
-        writeToSyslog(level, message);
+    LogLevel_en level = record.level; // 入队后 record 与槽位交换，不再可用
+    if (!threadBuffer.ring.tryPush(record) && !handleOverflow(threadBuffer, record)) {
+        threadBuffer.pool.releaseLocal(record.data, record.size, record.large);
+        return;
+    }
+    ++threadBuffer.pushed;
+
+    // 需要时等待所在批次落盘
+    if (waitForCommit.load(std::memory_order_relaxed)) {
+        int mode = durability.load(std::memory_order_relaxed);
+        if (mode == DURABILITY_GROUP_COMMIT || (mode == DURABILITY_ON_ERROR && level >= ERROR)) {
+            // 只有生产者自己会按 DROP_OLDEST 出队，刚写入的这条不会被丢弃
+            waitDurable(threadBuffer, threadBuffer.pushed,
+                        std::chrono::steady_clock::now() +
+                            std::chrono::microseconds(durabilityIntervalUs.load(std::memory_order_relaxed)));
+        }
     }
+}
+
+// 按当前格式生成一条完整日志
+void Logger::formatEntry(std::string& out, LogLevel_en level, const char* file, int line,
+                         uint64_t timestampNs, const char* message, size_t messageLen) {
+    char timestamp[TimestampCache::kMaxLength];
+    size_t timestampLen = formatTimestamp(timestampNs, timestamp);
+    appendLogEntry(out, jsonFormat, timestamp, timestampLen, level, file, line, message, messageLen);
+}
 
-    if (!remoteIp.empty() && remotePort != 0) { // 输出到远程服务器
-        remoteQueue.push(logEntry.str());
+// 把记录还原为完整日志文本
+void Logger::renderRecord(const LogRecord& record, std::string& entry, std::string* message) {
+    entry.clear();
+    if (record.formatted) {
+        entry.assign(record.data, record.size);
+        return;
     }
+
+    const LogCallSite* site = LogCallSiteRegistry::instance().find(record.callSiteId);
+    if (!site) return;
+
+    std::string local;
+    std::string& text = message ? *message : local;
+    text.clear();
+    formatPackedArgs(site->format.c_str(), record.data, record.size, text);
+    formatEntry(entry, record.level, site->file, site->line, record.timestamp, text.data(), text.size());
 }
 
-// 日志写入线程函数
-void Logger::writeThreadFunc() {
-    while (running || !logQueue.empty()) {
-        std::unique_lock<std::mutex> lock(mutex);
-        cv.wait(lock, [this] { return !logQueue.empty() || !running; });
+// 记录只在第一个接受它的 sink 处构造一次，之后各 sink 共享同一份
+void Logger::dispatchToSinks(LogLevel_en level, uint64_t timestamp, const char* entry, size_t entryLen,
+                             const char* message, size_t messageLen) {
+    LogSinkRecordPtr shared;
+    for (auto& sink : activeSinks) {
+        if (!sink->accepts(level)) continue;
+        if (!shared) {
+            std::shared_ptr<LogSinkRecord> record = std::make_shared<LogSinkRecord>();
+            record->timestamp = timestamp;
+            record->level = level;
+            record->entry.assign(entry, entryLen);
+            record->message.assign(message, messageLen);
+            shared = std::move(record);
+        }
+        sink->submit(shared);
+    }
+}
 
-        while (!logQueue.empty()) {
-            std::string message = logQueue.front();
-            logQueue.pop();
-            lock.unlock();
+// 写线程处理一条记录：延迟格式化的记录在此格式化并分发到其他输出
+void Logger::processRecord(const LogRecord& record) {
+    if (record.timestamp >= nextRotationNs.load(std::memory_order_relaxed)) rotateByTime(record.timestamp);
+    bool binary = binaryFormat.load(std::memory_order_relaxed);
+    if (binary && binarySessionPending.exchange(false, std::memory_order_acquire)) {
+        binaryEncoder.reset();
+    }
+
+    const LogCallSite* site = LogCallSiteRegistry::instance().find(record.callSiteId);
+    if (deduplicate.load(std::memory_order_relaxed)) {
+        if (collapseRepeat(record, site)) return;
+    } else if (repeatState.valid) {
+        flushRepeats();
+        repeatState.valid = false;
+    }
+    if (site) site->writtenCount.fetch_add(1, std::memory_order_relaxed);
 
-            writeToFile(message); // 写入日志到文件
+    if (sinksChanged.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(sinksMutex);
+        sinksChanged.store(false, std::memory_order_relaxed);
+        activeSinks = sinks;
+    }
 
-            lock.lock();
+    if (record.formatted) {
+        if (!activeSinks.empty()) { // syslog 等自带时间戳的输出只取时间戳之后的部分
+            size_t offset = logEntryBodyOffset(record.data, record.size, jsonFormat);
+            dispatchToSinks(record.level, record.timestamp, record.data, record.size, record.data + offset,
+                            record.size - offset);
+        }
+        if (binary) {
+            auto encode = [&] {
+                backendBinary.clear();
+                binaryEncoder.encodeText(backendBinary, record.timestamp, record.level, record.data, record.size,
+                                         timePrecision);
+            };
+            encode();
+            if (rotateBeforeBinaryWrite(backendBinary.size())) encode();
+            writeToFile(backendBinary.data(), backendBinary.size(), false);
+        } else {
+            writeToFile(record.data, record.size);
         }
+        return;
+    }
+
+    if (!binary) {
+        renderRecord(record, backendEntry, &backendMessage);
+        if (backendEntry.empty()) return;
+        if (!activeSinks.empty()) {
+            dispatchToSinks(record.level, record.timestamp, backendEntry.data(), backendEntry.size(),
+                            backendMessage.data(), backendMessage.size());
+        }
+        writeToFile(backendEntry);
+        return;
     }
+
+    // 二进制格式：文件中只写调用点编号和参数，仅在有其他输出时才格式化
+    if (!site) return;
+    if (!activeSinks.empty()) {
+        renderRecord(record, backendEntry, &backendMessage);
+        dispatchToSinks(record.level, record.timestamp, backendEntry.data(), backendEntry.size(),
+                        backendMessage.data(), backendMessage.size());
+    }
+    auto encode = [&] {
+        backendBinary.clear();
+        binaryEncoder.encodeRecord(backendBinary, record.callSiteId, *site, record.timestamp, record.level,
+                                   record.data, record.size, timePrecision);
+    };
+    encode();
+    if (rotateBeforeBinaryWrite(backendBinary.size())) encode();
+    writeToFile(backendBinary.data(), backendBinary.size(), false);
+}
+
+// 二进制记录编码后、写入前调用：写入会切换文件（待应用的写入后端或位置、按大小滚动）时先切换，
+// 使新段的第一条记录也在新会话中编码。返回 true 表示会话已重新开始，调用方需重新编码
+bool Logger::rotateBeforeBinaryWrite(size_t size) {
+    if (pendingWriterMode.load(std::memory_order_relaxed) >= 0) applyFileWriterMode();
+    if (logLocationPending.load(std::memory_order_relaxed)) applyLogLocation();
+    size_t limit = rotateBySize.load(std::memory_order_relaxed) ? maxFileSize : 0;
+    if (limit != 0 && segmentBytes != 0 && segmentBytes + size > limit) rotateLogs();
+    if (!binarySessionPending.exchange(false, std::memory_order_acquire)) return false;
+    binaryEncoder.reset();
+    return true;
+}
+
+// 比较记录与上一条消息：延迟格式化的记录比较调用点和打包参数，
+// 已格式化的记录比较时间戳之后的内容
+bool Logger::collapseRepeat(const LogRecord& record, const LogCallSite* site) {
+    size_t offset = record.formatted ? logEntryBodyOffset(record.data, record.size, jsonFormat) : 0;
+
+    // FNV-1a，以调用点和等级作为初值
+    uint64_t hash = 14695981039346656037ull ^ (static_cast<uint64_t>(record.callSiteId) << 8 | record.level);
+    hash ^= record.formatted ? 0x100000000ull : 0;
+    for (size_t i = offset; i < record.size; ++i) {
+        hash ^= static_cast<uint8_t>(record.data[i]);
+        hash *= 1099511628211ull;
+    }
+
+    RepeatState& state = repeatState;
+    if (state.valid && state.hash == hash && state.callSiteId == record.callSiteId && state.level == record.level) {
+        if (state.repeats++ == 0) state.firstRepeat = std::chrono::steady_clock::now();
+        state.lastTimestamp = record.timestamp;
+        return true;
+    }
+
+    flushRepeats();
+    state.valid = true;
+    state.hash = hash;
+    state.callSiteId = record.callSiteId;
+    state.level = record.level;
+    state.file = site ? site->file : nullptr;
+    state.line = site ? site->line : 0;
+    return false;
+}
+
+void Logger::flushRepeats() {
+    RepeatState& state = repeatState;
+    if (state.repeats == 0) return;
+
+    char message[64];
+    int len = snprintf(message, sizeof(message), "last message repeated %zu times", state.repeats);
+    std::string entry;
+    formatEntry(entry, state.level, state.file ? state.file : "logsys", state.line, state.lastTimestamp, message, len);
+    writeTextEntry(state.lastTimestamp, state.level, entry);
+    state.repeats = 0;
+}
+
+// 缓冲区已满时按溢出策略处理
+bool Logger::handleOverflow(ThreadLogBuffer& buffer, LogRecord& record) {
+    switch (overflowPolicy.load(std::memory_order_relaxed)) {
+        case DROP_OLDEST: {
+            // 生产者自己从队首取出一条丢弃，与写线程通过 CAS 竞争，不会重复消费
+            LogRecord oldest;
+            while (!buffer.ring.tryPush(record)) {
+                if (buffer.ring.tryPop(oldest)) {
+                    buffer.droppedOldest.store(buffer.droppedOldest.load(std::memory_order_relaxed) + 1,
+                                               std::memory_order_release);
+                    countDropped(oldest);
+                    buffer.pool.releaseLocal(oldest.data, oldest.size, oldest.large);
+                }
+            }
+            return true;
+        }
+        case BLOCK_WITH_TIMEOUT: {
+            auto deadline = std::chrono::steady_clock::now() +
+                            std::chrono::microseconds(blockTimeoutUs.load(std::memory_order_relaxed));
+            for (int spins = 0; ; ++spins) {
+                if (buffer.ring.tryPush(record)) return true;
+                if (std::chrono::steady_clock::now() >= deadline) break;
+                if (spins < 64) {
+                    std::this_thread::yield();
+                } else {
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                }
+            }
+            break;
+        }
+        case SPILL_TO_DISK:
+            spillToDisk(record);
+            spilledCounts[record.level - 1].fetch_add(1, std::memory_order_relaxed);
+            return false;
+        case DROP_NEWEST:
+        default:
+            break;
+    }
+
+    countDropped(record);
+    return false;
+}
+
+// 将记录追加到溢出文件，O_APPEND 保证多线程追加不交错
+void Logger::spillToDisk(const LogRecord& record) {
+    std::lock_guard<std::mutex> lock(spillMutex);
+    if (spillFd == -1) {
+        fs::path spillPath = logPath / (logName + "_overflow.log");
+        spillFd = open(spillPath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (spillFd == -1) {
+            std::cerr << "Failed to open overflow file: " << spillPath << std::endl;
+            countDropped(record);
+            return;
+        }
+    }
+
+    std::string line;
+    renderRecord(record, line);
+    line.push_back('\n');
+    if (write(spillFd, line.data(), line.size()) < 0) {
+        std::cerr << "Overflow write failed: " << strerror(errno) << std::endl;
+    }
+}
+
+void Logger::countDropped(const LogRecord& record) {
+    droppedCounts[record.level - 1].fetch_add(1, std::memory_order_relaxed);
+    if (const LogCallSite* site = LogCallSiteRegistry::instance().find(record.callSiteId)) {
+        site->droppedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// 丢弃计数有变化时（至多每秒一次）向日志文件写入一条汇总，避免静默丢日志
+void Logger::reportDrops(bool force) {
+    reportCounts(droppedCounts, reportedDrops, lastDropReport, "dropped %zu log records on buffer overflow", force);
+}
+
+// 限流与采样丢弃的条数同样周期性汇总
+void Logger::reportSuppressed(bool force) {
+    reportCounts(suppressedCounts, reportedSuppressed, lastSuppressReport,
+                 "suppressed %zu log records by rate limiting or sampling", force);
+}
+
+void Logger::reportCounts(const std::atomic<size_t>* counts, size_t* reported,
+                          std::chrono::steady_clock::time_point& lastReport, const char* what, bool force) {
+    auto now = std::chrono::steady_clock::now();
+    if (!force && now - lastReport < std::chrono::seconds(1)) return;
+
+    size_t current[5];
+    size_t total = 0;
+    for (int i = 0; i < 5; ++i) {
+        current[i] = counts[i].load(std::memory_order_relaxed);
+        total += current[i] - reported[i];
+    }
+    if (total == 0) return;
+
+    char summary[128];
+    snprintf(summary, sizeof(summary), what, total);
+    uint64_t timestampNs = timestampNowNs(static_cast<TimestampClock>(timestampClock.load(std::memory_order_relaxed)));
+    std::ostringstream oss;
+    oss << "[" << getCurrentTimeString(timestampNs) << "][WARNING][logsys] " << summary << " (";
+    for (int i = 0; i < 5; ++i) {
+        oss << (i ? " " : "") << getLogLevelString(static_cast<LogLevel_en>(i + 1)) << "="
+            << current[i] - reported[i];
+        reported[i] = current[i];
+    }
+    oss << ")";
+    writeTextEntry(timestampNs, WARNING, oss.str());
+    lastReport = now;
+}
+
+void Logger::writeTextEntry(uint64_t timestampNs, LogLevel_en level, const std::string& entry) {
+    if (timestampNs >= nextRotationNs.load(std::memory_order_relaxed)) rotateByTime(timestampNs);
+    if (!binaryFormat.load(std::memory_order_relaxed)) {
+        writeToFile(entry);
+        return;
+    }
+    if (binarySessionPending.exchange(false, std::memory_order_acquire)) binaryEncoder.reset();
+    auto encode = [&] {
+        backendBinary.clear();
+        binaryEncoder.encodeText(backendBinary, timestampNs, level, entry.data(), entry.size(), timePrecision);
+    };
+    encode();
+    if (rotateBeforeBinaryWrite(backendBinary.size())) encode();
+    writeToFile(backendBinary.data(), backendBinary.size(), false);
+}
+
+// 获取当前线程在本实例中的缓冲区
+ThreadLogBuffer& Logger::localBuffer() {
+    std::vector<ThreadBufferTable::Entry>& entries = threadBufferTable.entries;
+    for (auto& entry : entries) {
+        if (entry.instanceId == instanceId) return *entry.buffer;
+    }
+
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [](const ThreadBufferTable::Entry& entry) { return entry.owner.expired(); }),
+                  entries.end());
+    auto buffer = std::make_shared<ThreadLogBuffer>(maxQueueSize.load());
+    {
+        std::lock_guard<std::mutex> lock(bufferListMutex);
+        threadBuffers.push_back(buffer);
+        bufferListVersion.fetch_add(1, std::memory_order_release);
+    }
+    entries.push_back(ThreadBufferTable::Entry{instanceId, buffer.get(), buffer});
+    return *buffer;
+}
+
+// 按时间戳归并排空所有线程缓冲区
+bool Logger::drainBuffers() {
+    if (drainBuffersVersion != bufferListVersion.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(bufferListMutex);
+        drainBuffersSnapshot = threadBuffers;
+        drainBuffersVersion = bufferListVersion.load(std::memory_order_relaxed);
+    }
+
+    bool processed = false;
+    while (true) {
+        // 选出暂存记录时间戳最小的缓冲区
+        ThreadLogBuffer* next = nullptr;
+        for (auto& buffer : drainBuffersSnapshot) {
+            if (!buffer->hasStaged) {
+                buffer->hasStaged = buffer->ring.tryPop(buffer->staged);
+            }
+            if (buffer->hasStaged && (!next || buffer->staged.timestamp < next->staged.timestamp)) {
+                next = buffer.get();
+            }
+        }
+        if (!next) break;
+
+        processRecord(next->staged);
+        next->written.store(next->written.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        LogLevel_en level = next->staged.level;
+        next->pool.releaseRemote(next->staged.data, next->staged.size, next->staged.large);
+        next->staged.data = nullptr;
+        next->hasStaged = false;
+        processed = true;
+
+        if (level >= ERROR && durability.load(std::memory_order_relaxed) == DURABILITY_ON_ERROR) {
+            syncToDisk();
+        }
+    }
+
+    // 重复次数滞留超过时限时写出，之后的相同消息继续计数
+    if (repeatState.repeats != 0 &&
+        std::chrono::steady_clock::now() - repeatState.firstRepeat >=
+            std::chrono::microseconds(repeatFlushUs.load(std::memory_order_relaxed))) {
+        flushRepeats();
+    }
+
+    reportDrops();
+    reportSuppressed();
+
+    // 回收所属线程已退出且已排空的缓冲区
+    auto drained = [](const std::shared_ptr<ThreadLogBuffer>& buffer) {
+        return buffer->abandoned.load(std::memory_order_acquire) && !buffer->hasStaged && buffer->ring.empty();
+    };
+    bool hasAbandoned = false;
+    for (auto& buffer : drainBuffersSnapshot) {
+        if (drained(buffer)) {
+            hasAbandoned = true;
+            break;
+        }
+    }
+    if (hasAbandoned) {
+        std::lock_guard<std::mutex> lock(bufferListMutex);
+        for (auto it = threadBuffers.begin(); it != threadBuffers.end();) {
+            if (drained(*it)) {
+                it = threadBuffers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        drainBuffersSnapshot = threadBuffers;
+        drainBuffersVersion = bufferListVersion.fetch_add(1, std::memory_order_acq_rel) + 1;
+    }
+
+    return processed;
+}
+
+// 日志写入线程函数
+// 生产者不再通知写线程，空闲时以指数退避方式休眠轮询
+bool Logger::poll() {
+    if (logLocationPending.load(std::memory_order_relaxed)) applyLogLocation();
+    // 先取走 flushToDisk 的请求再排空缓冲区，请求之前写入的记录都会包含在随后的落盘中
+    bool syncWanted = syncRequested.load(std::memory_order_relaxed) && syncRequested.exchange(false);
+
+    // TSC 时钟每秒与系统时钟对齐一次
+    if (timestampClock.load(std::memory_order_relaxed) == TSC_CLOCK &&
+        std::chrono::steady_clock::now() - lastTscResync >= std::chrono::seconds(1)) {
+        TscClock::instance().resync();
+        lastTscResync = std::chrono::steady_clock::now();
+    }
+
+    bool processed = drainBuffers();
+    if (!processed && pendingRecords != 0) commitBatch(); // 队列已空，提交当前批次
+    maybeSync(syncWanted);
+    return processed;
 }
 
 // void Logger::writeThreadFunc() {
@@ -192,142 +829,384 @@ void Logger::writeThreadFunc() {
 // }
 
 
-// 压缩线程函数
-void Logger::compressThreadFunc() {
-    while (compressRunning || !compressQueue.empty()) {
-        std::unique_lock<std::mutex> lock(compressMutex);
-        compressCV.wait(lock, [this] { return !compressQueue.empty() || !compressRunning; });
-
-        if (!compressQueue.empty()) {
-            auto task = std::move(compressQueue.front());
-            compressQueue.pop();
-            lock.unlock();
-            task(); // 执行压缩任务
-        }
-    }
+// 写入日志到文件
+void Logger::writeToFile(const std::string& message) {
+    writeToFile(message.data(), message.size());
 }
 
-// 远程日志线程函数
-void Logger::remoteThreadFunc() {
-    while (remoteRunning || !remoteQueue.empty()) {
-        std::unique_lock<std::mutex> lock(mutex);
-        if (!remoteQueue.empty()) {
-            std::string msg = std::move(remoteQueue.front());
-            remoteQueue.pop();
-            lock.unlock();
+void Logger::writeToFile(const char* message, size_t size, bool newline) {
+    // outFile << message << std::endl;
+    // checkFileSize(); // 检查文件大小并触发日志滚动
 
-            if (sockfd == -1) {
-                sockfd = socket(AF_INET, SOCK_STREAM, 0);
-                if (sockfd < 0) {
-                    std::cerr << "Failed to create socket for remote logging" << std::endl;
-                    continue;
-                }
+    if (pendingWriterMode.load(std::memory_order_relaxed) >= 0) applyFileWriterMode();
+    if (logLocationPending.load(std::memory_order_relaxed)) applyLogLocation();
 
-                struct sockaddr_in serverAddr;
-                memset(&serverAddr, 0, sizeof(serverAddr));
-                serverAddr.sin_family = AF_INET;
-                serverAddr.sin_port = htons(remotePort);
-                inet_pton(AF_INET, remoteIp.c_str(), &serverAddr.sin_addr);
-
-                if (connect(sockfd, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
-                    std::cerr << "Failed to connect to remote server" << std::endl;
-                    close(sockfd);
-                    sockfd = -1;
-                    continue;
+    // 按已写字节数滚动，不访问文件系统
+    size_t total = size + (newline ? 1 : 0);
+    size_t limit = rotateBySize.load(std::memory_order_relaxed) ? maxFileSize : 0;
+    if (limit != 0 && segmentBytes + total > limit) {
+        if (rotateOnRecordBoundary.load(std::memory_order_relaxed) || binaryFormat.load(std::memory_order_relaxed)) {
+            if (segmentBytes != 0) rotateLogs(); // 单条超过上限的记录独占一个段
+        } else {
+            // 在恰好 maxFileSize 字节处切开记录，余下部分写入后续的段
+            while (segmentBytes + total > limit) {
+                if (segmentBytes < limit) {
+                    size_t head = static_cast<size_t>(limit - segmentBytes);
+                    appendToBatch(message, head, false);
+                    message += head;
+                    size -= head;
+                    total -= head;
                 }
+                rotateLogs();
             }
-
-            if (send(sockfd, msg.c_str(), msg.size(), MSG_DONTWAIT) == -1) {
-                std::cerr << "Remote send failed: " << strerror(errno) << std::endl;
-                close(sockfd);
-                sockfd = -1;
-            }
-        } else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
     }
+    appendToBatch(message, size, newline);
 }
 
-// 写入日志到文件
-void Logger::writeToFile(const std::string& message) {
-    // outFile << message << std::endl;
-    // checkFileSize(); // 检查文件大小并触发日志滚动
+// 追加到当前批次，达到提交策略的任一上限时提交
+void Logger::appendToBatch(const char* message, size_t size, bool newline) {
+    if (fileWriter->append(message, size, newline)) segmentBytes += size + (newline ? 1 : 0);
+    unsynced = true;
+    auto now = std::chrono::steady_clock::now();
+    if (pendingRecords++ == 0) pendingSince = now;
+    if (pendingRecords >= flushMaxRecords.load(std::memory_order_relaxed) ||
+        fileWriter->pendingBytes() >= flushMaxBytes.load(std::memory_order_relaxed) ||
+        now - pendingSince >= std::chrono::microseconds(flushMaxLatencyUs.load(std::memory_order_relaxed))) {
+        commitBatch();
+    }
+}
 
-    outFile << message << std::endl;
+void Logger::commitBatch() {
+    if (durability.load(std::memory_order_relaxed) == DURABILITY_GROUP_COMMIT) {
+        syncToDisk();
+        return;
+    }
+    fileWriter->setSyncOnFlush(flushSync.load(std::memory_order_relaxed));
+    fileWriter->flush();
+    pendingRecords = 0;
+}
 
-    // 更新计数器
-    logEntryCounter++;
+// 先记下各缓冲区的出队位置再落盘：这些记录此时都已交给写入后端，fdatasync 返回后即已持久化
+void Logger::syncToDisk() {
+    durableMarks.resize(drainBuffersSnapshot.size());
+    for (size_t i = 0; i < drainBuffersSnapshot.size(); ++i) {
+        const ThreadLogBuffer& buffer = *drainBuffersSnapshot[i];
+        durableMarks[i] = buffer.written.load(std::memory_order_relaxed) +
+                          buffer.droppedOldest.load(std::memory_order_acquire);
+    }
 
-    // 动态调整检查频率
-    if (logEntryCounter % (cachedFileSize < maxFileSize * checkThreshold ? lowCheckInterval : highCheckInterval) == 0) {
-        checkFileSize();
+    if (unsynced || pendingRecords != 0) {
+        fileWriter->setSyncOnFlush(false); // sync 本身会落盘
+        if (!fileWriter->sync()) std::cerr << "Log file sync failed: " << strerror(errno) << std::endl;
     }
+    pendingRecords = 0;
+    unsynced = false;
+    lastSync = std::chrono::steady_clock::now();
 
-    // 定期重置计数器
-    if (logEntryCounter >= 1000) {
-        logEntryCounter = 0;
+    for (size_t i = 0; i < drainBuffersSnapshot.size(); ++i) {
+        drainBuffersSnapshot[i]->durable.store(durableMarks[i]);
+    }
+    if (durabilityWaiters.load() > 0) {
+        { std::lock_guard<std::mutex> lock(durableMutex); }
+        durableCV.notify_all();
     }
 }
 
-// 写入日志到远程服务器
-void Logger::writeToRemote(const std::string& message) {
-    std::lock_guard<std::mutex> lock(mutex);
-    remoteQueue.push(message);
+void Logger::maybeSync(bool requested) {
+    if (!requested && (!unsynced || durability.load(std::memory_order_relaxed) != DURABILITY_PERIODIC)) return;
+    if (requested || std::chrono::steady_clock::now() - lastSync >=
+                         std::chrono::microseconds(durabilityIntervalUs.load(std::memory_order_relaxed))) {
+        syncToDisk();
+    }
 }
 
-// 写入日志到 syslog
-void Logger::writeToSyslog(LogLevel_en level, const std::string& message) {
-    int priority = LOG_INFO;
-    switch (level) {
-        case DEBUG: priority = LOG_DEBUG; break;
-        case INFO: priority = LOG_INFO; break;
-        case WARNING: priority = LOG_WARNING; break;
-        case ERROR: priority = LOG_ERR; break;
-        case FATAL: priority = LOG_CRIT; break;
+// 先登记等待者再检查进度，与 syncToDisk 先更新进度再检查等待者配对，不会错过唤醒
+bool Logger::waitDurable(ThreadLogBuffer& buffer, uint64_t ticket, std::chrono::steady_clock::time_point deadline) {
+    if (buffer.durable.load() >= ticket) return true;
+    durabilityWaiters.fetch_add(1);
+    wakeWriter();
+    bool durable;
+    {
+        std::unique_lock<std::mutex> lock(durableMutex);
+        durable = durableCV.wait_until(lock, deadline, [&] { return buffer.durable.load() >= ticket || !running; });
     }
-    syslog(priority, "%s", message.c_str()); // 写入 syslog
+    durabilityWaiters.fetch_sub(1);
+    return durable && buffer.durable.load() >= ticket;
 }
 
+void Logger::wakeWriter() {
+    LogWorkerPool::instance().wake(writerIndex);
+}
+
+// 旧后端提交剩余记录并关闭后，新后端在同一文件末尾继续写入
+void Logger::applyFileWriterMode() {
+    int mode = pendingWriterMode.exchange(-1);
+    if (mode < 0) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<LogFileWriter> writer = createLogFileWriter(static_cast<FileWriterMode>(mode), maxFileSize);
+    fileWriter->close();
+    pendingRecords = 0;
+    if (!writer->open(currentFilePath.string())) {
+        std::cerr << "Failed to open log file with the requested writer, keeping the current one: "
+                  << currentFilePath << std::endl;
+        if (!fileWriter->open(currentFilePath.string())) {
+            throw std::runtime_error("Failed to reopen log file: " + currentFilePath.string());
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> statsLock(writerStatsMutex);
+        retiredWriterStats.merge(fileWriter->stats());
+        fileWriter = std::move(writer);
+    }
+    fileWriterMode = static_cast<FileWriterMode>(mode);
+    segmentBytes = openedFileSize(*fileWriter, currentFilePath);
+
+    // 预先打开的下一段仍是旧后端，重新准备
+    discardNextSegment();
+    prepareNextSegment();
+}
+
+// 提交当前批次后切换到新位置的最新段；新位置不可用时报告错误并保留原位置
+void Logger::applyLogLocation() {
+    if (!logLocationPending.exchange(false, std::memory_order_acquire)) return;
+    if (pendingRecords != 0) commitBatch();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    fs::path oldPath = logPath;
+    std::string oldName = logName;
+    auto moveTo = [this](const fs::path& path, const std::string& name) {
+        std::lock_guard<std::mutex> spillLock(spillMutex); // spillToDisk 读取 logPath / logName
+        logPath = path;
+        logName = name;
+        if (spillFd != -1) { // 溢出文件随之换到新位置
+            close(spillFd);
+            spillFd = -1;
+        }
+    };
+    moveTo(pendingLogPath.empty() ? logPath : pendingLogPath, pendingLogName.empty() ? logName : pendingLogName);
+    pendingLogPath.clear();
+    pendingLogName.clear();
+
+    discardNextSegment();
+    try {
+        checkAndCreateLogDirectory();
+        if (!fileWriter->open(currentFilePath.string())) {
+            throw std::runtime_error("Failed to open log file: " + currentFilePath.string());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << ", keeping the current log location" << std::endl;
+        moveTo(oldPath, oldName);
+        checkAndCreateLogDirectory();
+        if (!fileWriter->open(currentFilePath.string())) {
+            throw std::runtime_error("Failed to reopen log file: " + currentFilePath.string());
+        }
+    }
+    segmentBytes = openedFileSize(*fileWriter, currentFilePath);
+    prepareNextSegment();
+    binarySessionPending.store(true, std::memory_order_release);
+}
 
 void Logger::rotateLogs() {
     std::lock_guard<std::mutex> lock(mutex);
-    outFile.close();  // 关闭当前日志文件
+    if (durability.load(std::memory_order_relaxed) != DURABILITY_NONE) {
+        fileWriter->sync(); // 旧文件先落盘，之后的落盘只覆盖新文件
+    }
+    // 取出后台预先打开的下一段，写线程只做指针交换
+    ++currentSegment;
+    currentFilePath = segmentPath(currentSegment);
+    std::unique_ptr<LogFileWriter> next = takeNextSegment(currentFilePath, segmentBytes);
+    if (!next) { // 预先打开失败时同步打开
+        next = createLogFileWriter(fileWriterMode, maxFileSize);
+        if (!next->open(currentFilePath.string())) {
+            throw std::runtime_error("Failed to open new log file: " + currentFilePath.string());
+        }
+        segmentBytes = openedFileSize(*next, currentFilePath);
+    }
+    std::shared_ptr<LogFileWriter> old;
+    {
+        std::lock_guard<std::mutex> statsLock(writerStatsMutex);
+        old.reset(fileWriter.release());
+        retiringWriters.push_back(old.get());
+        fileWriter = std::move(next);
+    }
+    pendingRecords = 0;
+    prepareNextSegment();
+
+    // 旧段的提交与关闭、符号链接更新、超出保留数量的最旧段删除都交给后台线程
+    segmentFiles.push_back(currentFilePath);
+    std::vector<fs::path> expired;
+    while (segmentFiles.size() > maxFileCount) {
+        expired.push_back(segmentFiles.front());
+        segmentFiles.pop_front();
+    }
+    fs::path link = activeLinkPath();
+    fs::path current = currentFilePath;
+    runInBackground([this, old, expired, link, current] {
+        old->close(); // 提交剩余记录并关闭旧段
+        {
+            std::lock_guard<std::mutex> statsLock(writerStatsMutex);
+            retiredWriterStats.merge(old->stats());
+            retiringWriters.erase(std::find(retiringWriters.begin(), retiringWriters.end(), old.get()));
+        }
+        updateActiveLink(link, current);
+        for (const fs::path& path : expired) {
+            if (::unlink(path.c_str()) != 0 && errno != ENOENT) {
+                std::cerr << "Failed to remove old log file " << path << ": " << strerror(errno) << std::endl;
+            }
+        }
+        std::cerr << "Log rotation completed. New log file created: " << current << std::endl;
+    });
 
-    // 删除最旧的文件（如果存在）
-    fs::path oldestFile = logPath / (logName + "_" + std::to_string(maxFileCount) + ".log");
-    if (fs::exists(oldestFile)) {
-        fs::remove(oldestFile);
+    binarySessionPending.store(true, std::memory_order_release); // 新文件重新写出会话头和调用点定义
+}
+
+// 记录所在周期的标记与下一个周期的起点（纳秒），按本地时间对齐
+static uint64_t rotationBoundary(uint64_t timestampNs, RotationPeriod period, std::string& tag) {
+    time_t seconds = static_cast<time_t>(timestampNs / 1000000000ull);
+    struct tm tm;
+    localtime_r(&seconds, &tm);
+    const char* format = "%Y%m%d%H%M";
+    tm.tm_sec = 0;
+    if (period != ROTATE_MINUTELY) {
+        tm.tm_min = 0;
+        format = "%Y%m%d%H";
+    }
+    if (period == ROTATE_DAILY) {
+        tm.tm_hour = 0;
+        format = "%Y%m%d";
+    }
+    char buf[16];
+    tag.assign(buf, strftime(buf, sizeof(buf), format, &tm));
+
+    switch (period) {
+        case ROTATE_MINUTELY: ++tm.tm_min; break;
+        case ROTATE_HOURLY:   ++tm.tm_hour; break;
+        case ROTATE_DAILY:    ++tm.tm_mday; break;
     }
+    tm.tm_isdst = -1; // 由 mktime 处理夏令时切换
+    time_t next = mktime(&tm);
+    if (next <= seconds) next = seconds + 1; // 防御 mktime 失败或时区回拨
+    return static_cast<uint64_t>(next) * 1000000000ull;
+}
 
-    // 向后移动其他文件
-    for (int i = maxFileCount - 1; i >= 1; --i) {
-        fs::path src = logPath / (logName + "_" + std::to_string(i) + ".log");
-        if (fs::exists(src)) {
-            fs::path dest = logPath / (logName + "_" + std::to_string(i + 1) + ".log");
-            fs::rename(src, dest);
+// 只在越过边界（或策略变化）时进入：每条记录的判断只是一次整数比较
+void Logger::rotateByTime(uint64_t timestampNs) {
+    bool rotate = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (rotationPolicy == ROTATE_BY_SIZE) {
+            periodTag.clear(); // 之后的段不带周期标记
+            nextRotationNs.store(UINT64_MAX, std::memory_order_relaxed);
+            return;
+        }
+        std::string tag;
+        nextRotationNs.store(rotationBoundary(timestampNs, rotationPeriod, tag), std::memory_order_relaxed);
+        if (tag == periodTag) return;
+        periodTag = tag;
+
+        if (segmentBytes != 0) {
+            rotate = true;
+        } else { // 当前段还没有内容：改用新周期的段名重新打开，不留下空段
+            discardNextSegment();
+            fs::path empty = currentFilePath;
+            currentFilePath = segmentPath(currentSegment);
+            if (!fileWriter->open(currentFilePath.string())) {
+                throw std::runtime_error("Failed to open new log file: " + currentFilePath.string());
+            }
+            segmentBytes = openedFileSize(*fileWriter, currentFilePath);
+            segmentFiles.back() = currentFilePath;
+            std::error_code ec;
+            if (fs::file_size(empty, ec) == 0 && !ec) fs::remove(empty, ec);
+            updateActiveLink(activeLinkPath(), currentFilePath);
+            prepareNextSegment();
+            binarySessionPending.store(true, std::memory_order_release);
         }
     }
+    if (rotate) rotateLogs();
+}
+
+// 后台线程打开 currentSegment 的下一段。调用方为写线程或持有 mutex
+void Logger::prepareNextSegment() {
+    fs::path path = segmentPath(currentSegment + 1);
+    FileWriterMode mode = fileWriterMode;
+    size_t segmentSize = maxFileSize;
+    {
+        std::lock_guard<std::mutex> lock(nextSegmentMutex);
+        nextSegmentPreparing = true;
+    }
+    runInBackground([this, path, mode, segmentSize] {
+        std::unique_ptr<LogFileWriter> writer = createLogFileWriter(mode, segmentSize);
+        uint64_t size = 0;
+        if (writer->open(path.string())) {
+            size = openedFileSize(*writer, path);
+        } else {
+            std::cerr << "Failed to pre-open next log file: " << path << std::endl;
+            writer.reset();
+        }
+        std::lock_guard<std::mutex> lock(nextSegmentMutex);
+        nextWriter = std::move(writer);
+        nextWriterPath = path;
+        nextWriterSize = size;
+        nextSegmentPreparing = false;
+        nextSegmentCV.notify_all();
+    });
+}
 
-    // 重命名当前文件为下一个编号的文件
-    fs::path newFilePath = logPath / (logName + "_2.log");
-    if (fs::exists(currentFilePath)) {
-        fs::rename(currentFilePath, newFilePath);
+// 准备仍在进行时等待其完成（至多一次 open 的耗时），路径不符时丢弃
+std::unique_ptr<LogFileWriter> Logger::takeNextSegment(const fs::path& path, uint64_t& size) {
+    std::unique_ptr<LogFileWriter> writer;
+    fs::path preparedPath;
+    {
+        std::unique_lock<std::mutex> lock(nextSegmentMutex);
+        nextSegmentCV.wait(lock, [this] { return !nextSegmentPreparing; });
+        writer = std::move(nextWriter);
+        preparedPath = nextWriterPath;
+        size = nextWriterSize;
     }
+    if (writer && preparedPath != path) { // 跨周期滚动时段名变化，预开的空段作废
+        writer->close();
+        writer.reset();
+        std::error_code ec;
+        if (fs::file_size(preparedPath, ec) == 0 && !ec) fs::remove(preparedPath, ec);
+    }
+    return writer;
+}
 
-    // 创建新的当前日志文件
-    currentFilePath = logPath / (logName + "_1.log");
-    outFile.open(currentFilePath, std::ios::app);
-    if (!outFile) {
-        throw std::runtime_error("Failed to open new log file: " + currentFilePath.string());
+// 关闭尚未使用的预开段，并删除它创建的空文件
+void Logger::discardNextSegment() {
+    std::unique_ptr<LogFileWriter> writer;
+    fs::path path;
+    {
+        std::unique_lock<std::mutex> lock(nextSegmentMutex);
+        nextSegmentCV.wait(lock, [this] { return !nextSegmentPreparing; });
+        writer = std::move(nextWriter);
+        path = nextWriterPath;
     }
+    if (!writer) return;
+    writer->close();
+    std::error_code ec;
+    if (fs::file_size(path, ec) == 0 && !ec) fs::remove(path, ec);
+}
 
-    std::cerr << "Log rotation completed. New log file created: " << currentFilePath << std::endl;
+void Logger::runInBackground(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(backgroundMutex);
+        ++backgroundPending;
+    }
+    LogWorkerPool::instance().post([this, task] {
+        task();
+        std::lock_guard<std::mutex> lock(backgroundMutex);
+        if (--backgroundPending == 0) backgroundCV.notify_all();
+    });
 }
 
 // 压缩文件
 void Logger::compressFile(const fs::path& filePath) {
-    std::unique_lock<std::mutex> lock(compressMutex);
-    compressQueue.push([this, filePath]() {
+    runInBackground([this, filePath]() {
         // 使用文件锁确保独占访问
         int fd = open(filePath.c_str(), O_RDWR);
         if (flock(fd, LOCK_EX | LOCK_NB) == 0) {
@@ -368,57 +1247,34 @@ void Logger::compressFile(const fs::path& filePath) {
         }
         close(fd);
     });
-    compressCV.notify_one();
 }
 
 // 获取当前时间字符串
 std::string Logger::getCurrentTimeString() {
-    auto now = std::chrono::system_clock::now();
-    auto now_c = std::chrono::system_clock::to_time_t(now);
-    std::tm* local_time = std::localtime(&now_c);
+    return getCurrentTimeString(timestampNowNs(static_cast<TimestampClock>(timestampClock.load(std::memory_order_relaxed))));
+}
 
-    std::ostringstream oss;
-    oss << std::put_time(local_time, "%Y-%m-%d %H:%M:%S");
-    
-    // 添加时间精度部分
-    auto duration = now.time_since_epoch();
-    auto sec = std::chrono::duration_cast<std::chrono::seconds>(duration);
-    duration -= sec;
-
-    switch (timePrecision) {
-        case SECONDS:
-            break;
-        case MILLISECONDS: {
-            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
-            oss << "." << std::setw(3) << std::setfill('0') << ms.count();
-            break;
-        }
-        case MICROSECONDS: {
-            auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration);
-            oss << "." << std::setw(6) << std::setfill('0') << us.count();
-            break;
-        }
-        case NANOSECONDS: {
-            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration);
-            oss << "." << std::setw(9) << std::setfill('0') << ns.count();
-            break;
-        }
-    }
-    return oss.str();
+std::string Logger::getCurrentTimeString(uint64_t timestampNs) {
+    char buf[TimestampCache::kMaxLength];
+    size_t len = formatTimestamp(timestampNs, buf);
+    return std::string(buf, len);
+}
+
+// 每个线程持有一份时间戳缓存，每秒只做一次 localtime_r
+size_t Logger::formatTimestamp(uint64_t timestampNs, char* out) {
+    static thread_local TimestampCache cache;
+    return cache.format(timestampNs, timePrecision, out);
 }
 
 // 其他成员函数实现
+// 写入后端只由写线程访问，由写线程在下一轮轮询时切换
 void Logger::setLogPath(const std::string& path) {
-    std::lock_guard<std::mutex> lock(mutex);
-    logPath = path;
-    checkAndCreateLogDirectory();
-    currentFilePath = logPath / (logName + "_1.log");
-
-    outFile.close();
-    outFile.open(currentFilePath, std::ios::app);
-    if (!outFile) {
-        throw std::runtime_error("Failed to reopen log file: " + currentFilePath.string());
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingLogPath = path;
     }
+    logLocationPending.store(true, std::memory_order_release);
+    wakeWriter();
 }
 
 void Logger::setMaxFileSize(size_t maxFileSize) {
@@ -430,34 +1286,78 @@ void Logger::setMaxFileCount(size_t maxFileCount) {
     std::lock_guard<std::mutex> lock(mutex);
     if (maxFileCount < 1) throw std::invalid_argument("Max file count must be ≥1");
     this->maxFileCount = maxFileCount;
+    pruneSegments();
 }
 
 void Logger::setLogName(const std::string& name) {
-    std::lock_guard<std::mutex> lock(mutex);
-    logName = name;
-    currentFilePath = logPath / (logName + "_1.log");
-
-    outFile.close();
-    outFile.open(currentFilePath, std::ios::app);
-    if (!outFile) {
-        throw std::runtime_error("Failed to reopen log file: " + currentFilePath.string());
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingLogName = name;
     }
+    logLocationPending.store(true, std::memory_order_release);
+    wakeWriter();
 }
 
 void Logger::enableLogLevel(LogLevel_en level, bool enable) {
-    std::lock_guard<std::mutex> lock(mutex);
-    logLevelEnabled.set(level - 1, enable);
+    uint32_t bit = 1u << (level - 1);
+    if (enable) {
+        levelMask.fetch_or(bit, std::memory_order_relaxed);
+    } else {
+        levelMask.fetch_and(~bit, std::memory_order_relaxed);
+    }
+    categories.invalidateAll(); // 顶层类别继承的等级变了
 }
 
 void Logger::enableLogLevelAbove(LogLevel_en level, bool enable) {
-    std::lock_guard<std::mutex> lock(mutex);
-    for (int i = level - 1; i < 5; ++i) {
-        logLevelEnabled.set(i, enable);
+    uint32_t bits = 0x1Fu & ~((1u << (level - 1)) - 1); // level 及以上的所有等级
+    if (enable) {
+        levelMask.fetch_or(bits, std::memory_order_relaxed);
+    } else {
+        levelMask.fetch_and(~bits, std::memory_order_relaxed);
     }
+    categories.invalidateAll();
+}
+
+void Logger::setCategoryLevel(const std::string& name, LogLevel_en level) {
+    categories.setMask(name, static_cast<int>(0x1Fu & ~((1u << (level - 1)) - 1)));
+}
+
+void Logger::clearCategoryLevel(const std::string& name) {
+    categories.setMask(name, -1);
+}
+
+void Logger::addSink(const std::shared_ptr<LogSink>& sink) {
+    sink->start();
+    std::lock_guard<std::mutex> lock(sinksMutex);
+    sinks.push_back(sink);
+    sinksChanged.store(true, std::memory_order_release);
+}
+
+void Logger::removeSink(const std::shared_ptr<LogSink>& sink) {
+    {
+        std::lock_guard<std::mutex> lock(sinksMutex);
+        auto it = std::find(sinks.begin(), sinks.end(), sink);
+        if (it == sinks.end()) return;
+        sinks.erase(it);
+        sinksChanged.store(true, std::memory_order_release);
+    }
+    sink->stop(); // 写线程更新快照前投递的记录按队列满丢弃计数
+}
+
+void Logger::replaceSink(std::shared_ptr<LogSink>& slot, const std::shared_ptr<LogSink>& sink) {
+    std::shared_ptr<LogSink> old;
+    {
+        std::lock_guard<std::mutex> lock(sinksMutex);
+        old = slot;
+        slot = sink;
+    }
+    if (old) removeSink(old);
+    if (sink) addSink(sink);
 }
 
 void Logger::setOutputToConsole(bool enable) {
-    outputToConsole = enable;
+    if (enable == static_cast<bool>(consoleSink)) return;
+    replaceSink(consoleSink, enable ? std::make_shared<ConsoleSink>() : nullptr);
 }
 
 void Logger::enableLogCompression(bool enable) {
@@ -477,41 +1377,154 @@ void Logger::setJsonFormat(bool enable) {
 }
 
 void Logger::enableRemoteLogging(const std::string& remoteIp, uint16_t remotePort) {
-    struct sockaddr_in sa;
-    if (inet_pton(AF_INET, remoteIp.c_str(), &(sa.sin_addr)) == 0) {
-        throw std::invalid_argument("Invalid IPv4 address: " + remoteIp);
-    }
-    this->remoteIp = remoteIp;
-    this->remotePort = remotePort;
+    replaceSink(remoteSink, std::make_shared<RemoteSink>(remoteIp, remotePort)); // 地址非法时抛出 invalid_argument
 }
 
 void Logger::enableSyslog(const std::string& ident, int facility, int syslogLevel) {
-    if (!syslogInitialized) {
-        openlog(ident.c_str(), LOG_PID | LOG_NDELAY, facility);
-        syslogInitialized = true;
-    }
-    syslogIdent = ident;
-    syslogFacility = facility;
-    this->syslogLevel = syslogLevel;
+    std::shared_ptr<LogSink> sink = std::make_shared<SyslogSink>(ident, facility);
+    // syslog 优先级数值越小越严重，映射为对应的最低日志等级
+    LogLevel_en level = FATAL;
+    if (syslogLevel >= LOG_DEBUG) level = DEBUG;
+    else if (syslogLevel >= LOG_NOTICE) level = INFO;
+    else if (syslogLevel >= LOG_WARNING) level = WARNING;
+    else if (syslogLevel >= LOG_ERR) level = ERROR;
+    sink->setLevel(level);
+    replaceSink(syslogSink, sink);
 }
 
 void Logger::setMaxQueueSize(size_t size) {
     maxQueueSize.store(size);
 }
 
+void Logger::setOverflowPolicy(OverflowPolicy policy, std::chrono::milliseconds blockTimeout) {
+    blockTimeoutUs.store(std::chrono::duration_cast<std::chrono::microseconds>(blockTimeout).count());
+    overflowPolicy.store(policy);
+}
+
+LogPoolStats Logger::getRecordPoolStats() {
+    LogPoolStats total;
+    total.slabSize = LogRecordPool::kSlabSize;
+    std::lock_guard<std::mutex> lock(bufferListMutex);
+    for (const auto& buffer : threadBuffers) {
+        LogPoolStats s = buffer->pool.stats();
+        total.slabsAllocated += s.slabsAllocated;
+        total.slabsInUse += s.slabsInUse;
+        total.largeRecordsInUse += s.largeRecordsInUse;
+        total.largeBytesInUse += s.largeBytesInUse;
+        total.largeRecordsTotal += s.largeRecordsTotal;
+    }
+    return total;
+}
+
+size_t Logger::getDroppedCount() const {
+    size_t total = 0;
+    for (const auto& count : droppedCounts) total += count.load(std::memory_order_relaxed);
+    return total;
+}
+
+size_t Logger::getDroppedCount(LogLevel_en level) const {
+    return droppedCounts[level - 1].load(std::memory_order_relaxed);
+}
+
+size_t Logger::getSpilledCount() const {
+    size_t total = 0;
+    for (const auto& count : spilledCounts) total += count.load(std::memory_order_relaxed);
+    return total;
+}
+
+size_t Logger::getSpilledCount(LogLevel_en level) const {
+    return spilledCounts[level - 1].load(std::memory_order_relaxed);
+}
+
+void Logger::setFlushPolicy(const LogFlushPolicy& policy) {
+    flushMaxBytes.store(policy.maxBytes ? policy.maxBytes : 1);
+    flushMaxRecords.store(policy.maxRecords ? policy.maxRecords : 1);
+    flushMaxLatencyUs.store(policy.maxLatency.count());
+    flushSync.store(policy.syncEachBatch);
+}
+
+LogWriterStats Logger::getWriterStats() const {
+    std::lock_guard<std::mutex> lock(writerStatsMutex);
+    LogWriterStats result = fileWriter->stats();
+    result.merge(retiredWriterStats);
+    for (const LogFileWriter* writer : retiringWriters) result.merge(writer->stats());
+    return result;
+}
+
+void Logger::setDurability(LogDurability mode, std::chrono::milliseconds interval, bool waitForCommit) {
+    durabilityIntervalUs.store(std::chrono::duration_cast<std::chrono::microseconds>(interval).count());
+    this->waitForCommit.store(waitForCommit);
+    durability.store(mode);
+    wakeWriter();
+}
+
+bool Logger::flushToDisk(std::chrono::milliseconds timeout) {
+    ThreadLogBuffer& buffer = localBuffer();
+    // 落盘进度把 DROP_OLDEST 丢弃的记录也算作已出队：有丢弃时仍落盘其余记录，但返回 false，
+    // 每次丢弃只报告一次
+    uint64_t dropped = buffer.droppedOldest.load(std::memory_order_relaxed);
+    bool lost = dropped != buffer.droppedReported;
+    buffer.droppedReported = dropped;
+    if (buffer.durable.load() >= buffer.pushed) return !lost;
+    syncRequested.store(true);
+    return waitDurable(buffer, buffer.pushed, std::chrono::steady_clock::now() + timeout) && !lost;
+}
+
+void Logger::setRotateOnRecordBoundary(bool enable) {
+    rotateOnRecordBoundary.store(enable);
+}
+
+void Logger::setRotationPolicy(RotationPolicy policy, RotationPeriod period) {
+    std::lock_guard<std::mutex> lock(mutex);
+    rotationPolicy = policy;
+    rotationPeriod = period;
+    rotateBySize.store(policy != ROTATE_BY_TIME);
+    nextRotationNs.store(0); // 下一条记录重新确定周期
+}
+
+void Logger::setFileWriterMode(FileWriterMode mode) {
+    pendingWriterMode.store(mode);
+}
+
+void Logger::setDeduplication(bool enable, std::chrono::milliseconds flushTimeout) {
+    repeatFlushUs.store(std::chrono::duration_cast<std::chrono::microseconds>(flushTimeout).count());
+    deduplicate.store(enable);
+}
+
+void Logger::setThrottle(LogLevel_en level, const LogThrottleConfig& config) {
+    levelThrottles[level - 1].configure(config);
+}
+
+size_t Logger::getSuppressedCount() const {
+    size_t total = 0;
+    for (const auto& count : suppressedCounts) total += count.load(std::memory_order_relaxed);
+    return total;
+}
+
+size_t Logger::getSuppressedCount(LogLevel_en level) const {
+    return suppressedCounts[level - 1].load(std::memory_order_relaxed);
+}
+
 void Logger::setTimePrecision(TimePrecision precision) {
     timePrecision = precision;
 }
 
-std::string Logger::getLogLevelString(LogLevel_en level) {
-    switch (level) {
-        case DEBUG:   return "DEBUG";
-        case INFO:    return "INFO";
-        case WARNING: return "WARNING";
-        case ERROR:   return "ERROR";
-        case FATAL:   return "FATAL";
-        default:      return "UNKNOWN";
-    }
+void Logger::setTimestampClock(TimestampClock clock) {
+    if (clock == TSC_CLOCK && !TscClock::instance().available()) clock = SYSTEM_CLOCK;
+    timestampClock.store(clock);
+}
+
+void Logger::setDeferredFormatting(bool enable) {
+    deferredFormatting.store(enable);
+}
+
+void Logger::setBinaryFormat(bool enable) {
+    if (enable) binarySessionPending.store(true, std::memory_order_release);
+    binaryFormat.store(enable);
+}
+
+const char* Logger::getLogLevelString(LogLevel_en level) {
+    return logLevelName(level);
 }
 
 // void Logger::checkFileSize() {
@@ -527,16 +1540,11 @@ std::string Logger::getLogLevelString(LogLevel_en level) {
 //     }
 // }
 
-void Logger::checkFileSize() {
+// 预分配的文件以写入后端记录的长度为准，否则 stat 一次
+uint64_t Logger::openedFileSize(const LogFileWriter& writer, const fs::path& path) {
+    uint64_t size;
+    if (writer.logicalSize(size)) return size;
     std::error_code ec;
-    cachedFileSize = fs::file_size(currentFilePath, ec);
-    if (ec) {
-        std::cerr << "Failed to get file size: " << ec.message() << std::endl;
-        return;
-    }
-
-    // 触发日志滚动
-    if (cachedFileSize >= maxFileSize) {
-        rotateLogs();
-    }
+    size = fs::file_size(path, ec);
+    return ec ? 0 : size;
 }
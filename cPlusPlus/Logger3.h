@@ -12,6 +12,7 @@
 #include <iomanip>
 #include <bitset>
 #include <vector>
+#include <deque>
 #include <filesystem>
 #include <thread>
 #include <atomic>
@@ -26,6 +27,19 @@
 #include <syslog.h>     // 用于 syslog 支持
 #include <fcntl.h>      // 用于文件锁
 #include <cstdarg>      // 用于变参处理
+#include "LogLevel.h"      // 日志等级与时间精度
+#include "LogRingBuffer.h" // 每线程无锁环形缓冲区
+#include "LogArgs.h"       // 延迟格式化的参数打包
+#include "LogFormat.h"     // 编译期格式串解析
+#include "LogTimestamp.h"  // 时间戳缓存与 TSC 时钟
+#include "LogRecordPool.h" // 每线程记录内存池
+#include "LogLayout.h"     // 文本 / JSON 日志行布局
+#include "LogCallSite.h"   // 调用点登记表
+#include "LogBinaryFormat.h" // 紧凑二进制日志格式
+#include "LogFileWriter.h"  // 日志文件写入后端
+#include "LogSink.h"        // 终端 / syslog / 远程等输出目标
+#include "LogWorkerPool.h"  // 实例间共享的写线程与后台任务线程
+#include "LogCategory.h"    // 点分层级的日志类别
 
 #if __cplusplus >= 201703L
 #include <filesystem>
@@ -35,29 +49,89 @@ namespace fs = std::filesystem;
 namespace fs = std::experimental::filesystem;
 #endif
 
-// 日志等级枚举
-enum LogLevel_en {
-    DEBUG = 1,
-    INFO,
-    WARNING,
-    ERROR,
-    FATAL
+// 缓冲区满时的处理策略
+enum OverflowPolicy {
+    DROP_NEWEST,        // 丢弃新日志，生产者延迟最低
+    DROP_OLDEST,        // 丢弃缓冲区中最旧的日志（默认）
+    BLOCK_WITH_TIMEOUT, // 阻塞等待空位，超时后丢弃新日志
+    SPILL_TO_DISK       // 写入溢出文件，不丢日志
 };
 
-// 时间精度枚举
-enum TimePrecision {
-    SECONDS,
-    MILLISECONDS,
-    MICROSECONDS,
-    NANOSECONDS
+// 落盘策略
+enum LogDurability {
+    DURABILITY_NONE,         // 只交给内核，不主动落盘（默认）
+    DURABILITY_PERIODIC,     // 每隔固定时间 fdatasync 一次
+    DURABILITY_ON_ERROR,     // 写出 ERROR / FATAL 后立即 fdatasync
+    DURABILITY_GROUP_COMMIT  // 每批提交都 fdatasync，同一批的记录共享一次落盘
 };
 
-class Logger {
+// 滚动条件
+enum RotationPolicy {
+    ROTATE_BY_SIZE,          // 写满 maxFileSize 时滚动（默认），段名 <logName>.<序号>.log
+    ROTATE_BY_TIME,          // 每个周期一个段，段名 <logName>.<周期>.<序号>.log
+    ROTATE_BY_TIME_OR_SIZE   // 进入新周期或写满 maxFileSize 时滚动，段名同上
+};
+
+// 时间滚动周期，按本地时间对齐
+enum RotationPeriod {
+    ROTATE_MINUTELY,         // 周期标记 YYYYMMDDHHMM
+    ROTATE_HOURLY,           // 周期标记 YYYYMMDDHH
+    ROTATE_DAILY             // 周期标记 YYYYMMDD
+};
+
+// 日志记录：时间戳用于后端按时间归并各线程缓冲区
+struct LogRecord {
+    uint64_t timestamp = 0;                // 记录产生时间（自 epoch 起的纳秒数）
+    LogLevel_en level = INFO;              // 日志等级
+    uint32_t callSiteId = 0;               // 调用点编号，0 表示未登记
+    char* data = nullptr;                  // 内容：已格式化的日志，或延迟格式化模式下的打包参数，存放在记录池中
+    uint32_t size = 0;                     // 内容长度
+    bool large = false;                    // 内容是否走了大记录回退路径
+    bool formatted = true;                 // data 是否为已格式化的日志（否则为打包参数，按 callSiteId 格式化）
+};
+
+// 每个生产线程独占的日志缓冲区
+struct ThreadLogBuffer {
+    explicit ThreadLogBuffer(size_t capacity) : ring(capacity) {}
+
+    // 释放仍在队列中的记录
+    ~ThreadLogBuffer() {
+        LogRecord record;
+        while (ring.tryPop(record)) pool.releaseLocal(record.data, record.size, record.large);
+        if (hasStaged) pool.releaseLocal(staged.data, staged.size, staged.large);
+    }
+
+    LogRecordPool pool;                    // 记录内容的内存池
+    LogRingBuffer<LogRecord> ring;         // 无锁环形缓冲区
+    std::atomic<bool> abandoned{false};    // 所属线程已退出，排空后可回收
+
+    // 落盘进度，均为自创建以来的累计条数；已出队条数 = written + droppedOldest
+    uint64_t pushed = 0;                   // 成功入队（仅生产者访问）
+    std::atomic<uint64_t> droppedOldest{0}; // 生产者按 DROP_OLDEST 自行出队丢弃（仅生产者写）
+    std::atomic<uint64_t> written{0};      // 写线程已写出（仅写线程写）
+    std::atomic<uint64_t> durable{0};      // 已落盘的出队条数，写线程在 fdatasync 之后更新
+    uint64_t droppedReported = 0;          // 上次 flushToDisk 时的 droppedOldest（仅生产者访问）
+
+    // 以下成员只由写线程访问：归并时暂存从环形缓冲区取出的队首记录
+    LogRecord staged;
+    bool hasStaged = false;
+};
+
+class Logger : private LogPollable {
 public:
     // 获取单例实例
     static Logger& getInstance(const std::string& path = "/tmp/logs", const std::string& name = "app_log",
                                size_t maxFileSize = 1024 * 1024, size_t maxFileCount = 5);
 
+    // 命名实例登记表：每个实例有独立的文件、滚动与等级设置，写线程和后台任务线程由
+    // LogWorkerPool 在所有实例（含 getInstance 的单例）间共享。
+    // create 在同名实例已存在时抛出 invalid_argument；find 找不到时返回 nullptr；
+    // destroy 写完剩余日志后销毁实例，调用方需保证此后不再使用该实例
+    static Logger& create(const std::string& instanceName, const std::string& path, const std::string& name,
+                          size_t maxFileSize = 1024 * 1024, size_t maxFileCount = 5);
+    static Logger* find(const std::string& instanceName);
+    static bool destroy(const std::string& instanceName);
+
     // 禁止拷贝和赋值
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
@@ -65,7 +139,25 @@ public:
     // 日志记录方法
     void log(LogLevel_en level, const std::string& format, const char* file, int line, ...);
 
-    // 修改配置方法
+    // 格式串为字面量时匹配此重载，避免每次调用构造 std::string
+    void log(LogLevel_en level, const char* format, const char* file, int line, ...);
+
+    // 按已登记的调用点记录日志，等级、格式串、文件和行号取自调用点。一般通过 LOG.h 中的宏调用
+    void log(const LogCallSite* site, ...);
+
+    // 同上，是否启用由类别的生效等级决定。一般通过 LOGSYS_CLOG_TO 宏调用
+    void log(const LogCategory& category, const LogCallSite* site, ...);
+
+    // 类型安全的日志记录方法：Fmt::str() 返回格式串，编译期校验参数，
+    // 调用线程只打包参数，格式化由写线程完成。一般通过 LOGGER_LOGF 宏调用
+    template <typename Fmt, typename... Args>
+    void logf(LogLevel_en level, const char* file, int line, const Args&... args);
+
+    template <typename Fmt, typename... Args>
+    void logf(const LogCallSite& site, const Args&... args);
+
+    // 修改配置方法。setLogPath / setLogName 由写线程在下一轮轮询时切换，
+    // 新位置不可用时报告错误并继续写原位置
     void setLogPath(const std::string& path);
     void setMaxFileSize(size_t maxFileSize);
     void setMaxFileCount(size_t maxFileCount);
@@ -75,7 +167,38 @@ public:
     void enableLogLevel(LogLevel_en level, bool enable);
     void enableLogLevelAbove(LogLevel_en level, bool enable);
 
-    // 控制是否输出到终端
+    // 运行时等级判断：一次 relaxed 原子读，供日志宏在求值参数之前调用
+    bool isLevelEnabled(LogLevel_en level) const {
+        return (levelMask.load(std::memory_order_relaxed) >> (level - 1)) & 1u;
+    }
+
+    // 调用点是否启用：没有等级覆盖时按调用点等级判断
+    bool isEnabled(const LogCallSite& site) const {
+        int levelOverride = site.levelOverride.load(std::memory_order_relaxed);
+        return levelOverride == CALLSITE_DEFAULT ? isLevelEnabled(site.level) : levelOverride == CALLSITE_ENABLED;
+    }
+
+    // 调用点在类别下是否启用：没有等级覆盖时按类别的生效等级判断
+    bool isEnabled(const LogCallSite& site, const LogCategory& category) const {
+        int levelOverride = site.levelOverride.load(std::memory_order_relaxed);
+        return levelOverride == CALLSITE_DEFAULT ? category.isEnabled(site.level) : levelOverride == CALLSITE_ENABLED;
+    }
+
+    // 类别句柄（如 "net.rpc"），不存在时连同各级父类别一起创建，在 Logger 生命周期内有效。
+    // 调用方应缓存句柄，之后的等级判断只读句柄上缓存的生效等级
+    LogCategory& category(const std::string& name) { return categories.get(name); }
+
+    // 类别等级：该类别及没有单独设置的子孙类别只输出 level 及以上的日志；
+    // clearCategoryLevel 恢复继承。没有设置过的顶层类别跟随 enableLogLevel 等设置
+    void setCategoryLevel(const std::string& name, LogLevel_en level);
+    void clearCategoryLevel(const std::string& name);
+
+    // 添加 / 移除输出目标。写线程把每条记录格式化一次后投递到各 sink 的队列，
+    // 输出在 sink 自己的线程中完成，不增加 log() 的延迟；移除时先输出完队列中的记录
+    void addSink(const std::shared_ptr<LogSink>& sink);
+    void removeSink(const std::shared_ptr<LogSink>& sink);
+
+    // 控制是否输出到终端（ConsoleSink）
     void setOutputToConsole(bool enable);
 
     // 压缩日志开关
@@ -86,16 +209,82 @@ public:
     // JSON 格式日志开关
     void setJsonFormat(bool enable);
 
-    // 远程日志配置
+    // 远程日志（RemoteSink）与 syslog（SyslogSink，syslogLevel 及更严重的优先级才输出）配置
     void enableRemoteLogging(const std::string& remoteIp, uint16_t remotePort);
     void enableSyslog(const std::string& ident, int facility, int syslogLevel);
 
-    // 设置日志队列最大大小
+    // 设置每个生产线程缓冲区的最大大小（对之后新建的线程缓冲区生效）
     void setMaxQueueSize(size_t size);
 
+    // 设置缓冲区满时的处理策略，blockTimeout 仅对 BLOCK_WITH_TIMEOUT 生效
+    void setOverflowPolicy(OverflowPolicy policy,
+                           std::chrono::milliseconds blockTimeout = std::chrono::milliseconds(10));
+
+    // 所有线程记录内存池的占用统计之和
+    LogPoolStats getRecordPoolStats();
+
+    // 因缓冲区已满而丢弃的日志条数（全部等级 / 指定等级）
+    size_t getDroppedCount() const;
+    size_t getDroppedCount(LogLevel_en level) const;
+
+    // 写入溢出文件的日志条数（全部等级 / 指定等级）
+    size_t getSpilledCount() const;
+    size_t getSpilledCount(LogLevel_en level) const;
+
+    // 设置批量提交策略：累积的字节数、记录数或等待时间达到上限时提交一批，写线程空闲时也立即提交；
+    // syncEachBatch 为 true 时每批写出后 fdatasync（io_uring 后端以链接操作执行）
+    void setFlushPolicy(const LogFlushPolicy& policy);
+
+    // 文件写入统计（记录数、批次数、write/writev 与 fdatasync 调用次数），切换后端后继续累计
+    LogWriterStats getWriterStats() const;
+
+    // 设置落盘策略。interval 为 DURABILITY_PERIODIC 的落盘间隔；waitForCommit 为 true 时，
+    // 会触发落盘的记录（GROUP_COMMIT 下的全部记录、ON_ERROR 下的 ERROR / FATAL）在 log() 中
+    // 阻塞到所在批次落盘，最长等待 interval（GROUP_COMMIT / ON_ERROR 下 interval 仅作超时）
+    void setDurability(LogDurability mode, std::chrono::milliseconds interval = std::chrono::milliseconds(100),
+                       bool waitForCommit = false);
+
+    // 阻塞到本线程此前写入的日志全部落盘，写线程会为此立即执行一次 fdatasync；超时返回 false。
+    // 自上次调用以来本线程有记录按 DROP_OLDEST 被丢弃时，这些记录不会落盘，同样返回 false
+    bool flushToDisk(std::chrono::milliseconds timeout = std::chrono::milliseconds(1000));
+
+    // 滚动位置。true（默认）：写入某条记录会超过 maxFileSize 时先滚动，段不超过 maxFileSize
+    // （单条超长记录除外）；false：在恰好 maxFileSize 字节处切开记录。二进制格式始终按记录边界滚动
+    void setRotateOnRecordBoundary(bool enable);
+
+    // 滚动条件与周期。按时间滚动时以记录时间戳判断周期，周期边界只在跨越时计算一次；
+    // 段序号跨周期连续递增，maxFileCount 对全部段生效
+    void setRotationPolicy(RotationPolicy policy, RotationPeriod period = ROTATE_DAILY);
+
+    // 选择文件写入后端，由写线程在下一条记录写入前切换；MMAP_WRITER 的段大小取切换时的 maxFileSize，
+    // IO_URING_WRITER 在 io_uring 不可用时使用 WRITEV_WRITER；DIRECT_IO_WRITER / DONTNEED_WRITER 不占用页缓存
+    void setFileWriterMode(FileWriterMode mode);
+
+    // 重复消息折叠：同一调用点连续产生的相同消息只写一条，之后在内容变化或超过 flushTimeout
+    // 时补一条 "last message repeated N times"。比较基于哈希，延迟格式化的记录无需格式化即可比较
+    void setDeduplication(bool enable, std::chrono::milliseconds flushTimeout = std::chrono::milliseconds(1000));
+
+    // 按等级设置限流与采样，对没有单独配置的调用点生效；
+    // 单个调用点的配置见 LogCallSiteRegistry::setThrottle
+    void setThrottle(LogLevel_en level, const LogThrottleConfig& config);
+
+    // 被限流或采样丢弃的日志条数（全部等级 / 指定等级）
+    size_t getSuppressedCount() const;
+    size_t getSuppressedCount(LogLevel_en level) const;
+
     // 设置时间戳精度
     void setTimePrecision(TimePrecision precision);
 
+    // 设置时间戳时钟源，TSC_CLOCK 在不支持恒定 TSC 的 CPU 上退回系统时钟
+    void setTimestampClock(TimestampClock clock);
+
+    // 延迟格式化开关：开启后调用线程只拷贝调用点编号和参数，格式化由写线程完成
+    void setDeferredFormatting(bool enable);
+
+    // 二进制日志格式开关：开启后文件中写入紧凑二进制记录（调用点定义每个文件一次），
+    // 用 logsys-decode 还原为文本或 JSON；开启时总是使用延迟格式化
+    void setBinaryFormat(bool enable);
+
     // 析构函数
     ~Logger();
 
@@ -107,73 +296,221 @@ private:
     void checkAndCreateLogDirectory();
 
     // 获取日志等级字符串
-    std::string getLogLevelString(LogLevel_en level);
+    static const char* getLogLevelString(LogLevel_en level);
 
-    // 检查文件大小并触发日志滚动
-    void checkFileSize();
+    // 刚打开的段的当前长度（只在打开时调用）
+    static uint64_t openedFileSize(const LogFileWriter& writer, const fs::path& path);
 
-    // 日志滚动
+    // 日志滚动：换用后台预先打开的下一段，旧段的关闭与最旧段的删除在后台完成
     void rotateLogs();
 
+    // 记录时间戳越过周期边界时调用（写线程）：确定记录所在周期和下一个边界，周期变化时滚动
+    void rotateByTime(uint64_t timestampNs);
+
+    // 后台预先打开下一段 / 取出预开的段（路径不符时返回空）/ 丢弃未使用的预开段
+    void prepareNextSegment();
+    std::unique_ptr<LogFileWriter> takeNextSegment(const fs::path& path, uint64_t& size);
+    void discardNextSegment();
+
+    // 在共享的后台任务线程执行任务，析构时等待本实例提交的任务全部完成
+    void runInBackground(std::function<void()> task);
+
+    // 段文件路径（含当前周期标记）；扫描目录中已有的段，按序号排入 segmentFiles
+    fs::path segmentPath(uint64_t sequence) const;
+    void scanSegments();
+
+    // 让 <logName>.log 指向当前段
+    fs::path activeLinkPath() const;
+    static void updateActiveLink(const fs::path& link, const fs::path& segment);
+
+    // 删除超出 maxFileCount 的旧段
+    void pruneSegments();
+
+    // 应用 setFileWriterMode 请求的后端（写线程调用）
+    void applyFileWriterMode();
+
+    // 应用 setLogPath / setLogName 请求的位置（写线程调用）
+    void applyLogLocation();
+
     // 压缩文件
     void compressFile(const fs::path& filePath);
 
     // 获取当前时间字符串
     std::string getCurrentTimeString();
+    std::string getCurrentTimeString(uint64_t timestampNs);
+
+    // 把时间戳格式化到 out（至少 TimestampCache::kMaxLength 字节），返回长度
+    size_t formatTimestamp(uint64_t timestampNs, char* out);
+
+    // 获取当前线程在本实例中的缓冲区，首次调用时注册
+    ThreadLogBuffer& localBuffer();
+
+    // 按时间戳归并排空所有线程缓冲区，返回是否处理了日志
+    bool drainBuffers();
+
+    // 变参日志记录的公共实现
+    // site 非空时使用已登记的调用点，不再查表；category 非空时按类别判断等级
+    void vlog(LogLevel_en level, const char* format, const char* file, int line, va_list args,
+              const LogCallSite* site = nullptr, const LogCategory* category = nullptr);
+
+    // 当前线程构造记录内容用的可复用缓冲区
+    static std::string& pendingPayload();
+
+    // 按当前格式（纯文本 / JSON）生成一条完整日志，追加到 out
+    void formatEntry(std::string& out, LogLevel_en level, const char* file, int line,
+                     uint64_t timestampNs, const char* message, size_t messageLen);
+
+    // 把记录还原为完整日志文本写入 entry，延迟格式化的记录在此完成格式化，message 非空时同时返回消息正文
+    void renderRecord(const LogRecord& record, std::string& entry, std::string* message = nullptr);
+
+    // 把一条已格式化的记录投递给接受该等级的 sink（写线程）
+    void dispatchToSinks(LogLevel_en level, uint64_t timestamp, const char* entry, size_t entryLen,
+                         const char* message, size_t messageLen);
+
+    // 替换 setOutputToConsole 等接口管理的内置 sink
+    void replaceSink(std::shared_ptr<LogSink>& slot, const std::shared_ptr<LogSink>& sink);
+
+    // 写线程处理一条记录
+    void processRecord(const LogRecord& record);
+
+    // 把内容拷入当前线程的记录池并放入缓冲区
+    void submitRecord(LogRecord& record, const std::string& payload);
+
+    // 缓冲区已满时按溢出策略处理，返回记录是否最终入队
+    bool handleOverflow(ThreadLogBuffer& buffer, LogRecord& record);
 
-    // 日志写入线程函数
-    void writeThreadFunc();
+    // 将记录追加到溢出文件
+    void spillToDisk(const LogRecord& record);
 
-    // 压缩线程函数
-    void compressThreadFunc();
+    // 丢弃计数有变化时向日志文件写入一条汇总，force 为 true 时忽略频率限制
+    void reportDrops(bool force = false);
 
-    // 远程日志线程函数
-    void remoteThreadFunc();
+    // 按等级和调用点统计一条被丢弃的记录
+    void countDropped(const LogRecord& record);
+
+    // 限流与采样检查，在格式化之前进行；被丢弃时计数并返回 false
+    bool admitRecord(const LogCallSite& site, uint64_t timestampNs) {
+        const LogThrottle& throttle = site.throttle.active() ? site.throttle : levelThrottles[site.level - 1];
+        if (!throttle.active() || throttle.admit(timestampNs, site.throttleState)) return true;
+        site.suppressedCount.fetch_add(1, std::memory_order_relaxed);
+        suppressedCounts[site.level - 1].fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // 写线程：与上一条消息相同时计入重复次数并返回 true，调用方不再输出该记录
+    bool collapseRepeat(const LogRecord& record, const LogCallSite* site);
+
+    // 写线程：输出尚未写出的重复次数
+    void flushRepeats();
+
+    // 限流或采样丢弃计数有变化时向日志文件写入一条汇总，force 为 true 时忽略频率限制
+    void reportSuppressed(bool force = false);
+
+    // 把 counts 相对 reported 的增量写成一条汇总，至多每秒一次
+    void reportCounts(const std::atomic<size_t>* counts, size_t* reported,
+                      std::chrono::steady_clock::time_point& lastReport, const char* what, bool force);
+
+    // 写线程写入一条已格式化的日志，二进制格式下编码为文本记录
+    void writeTextEntry(uint64_t timestampNs, LogLevel_en level, const std::string& entry);
+
+    // 共享写线程轮询一次：按需落盘、排空各线程缓冲区，队列已空时提交当前批次
+    bool poll() override;
+
+    // 写线程：把已累积的记录作为一批提交
+    void commitBatch();
+
+    // 写线程：提交并 fdatasync，之后公布各缓冲区的落盘进度并唤醒等待者
+    void syncToDisk();
+
+    // 写线程：按落盘策略或 flushToDisk 请求（requested）决定是否落盘
+    void maybeSync(bool requested);
+
+    // 生产者：等待 buffer 中前 ticket 条出队的记录落盘。出队条数包含 DROP_OLDEST 丢弃的记录，
+    // 返回 true 不代表其中被丢弃的记录已写入，由调用方对照 droppedOldest 判断
+    bool waitDurable(ThreadLogBuffer& buffer, uint64_t ticket, std::chrono::steady_clock::time_point deadline);
+
+    // 唤醒处于退避休眠中的写线程
+    void wakeWriter();
 
     // 写入日志到文件
     void writeToFile(const std::string& message);
+    void writeToFile(const char* message, size_t size, bool newline = true);
+    void appendToBatch(const char* message, size_t size, bool newline);
 
-    // 写入日志到远程服务器
-    void writeToRemote(const std::string& message);
-
-    // 写入日志到 syslog
-    void writeToSyslog(LogLevel_en level, const std::string& message);
+    // 写线程：size 字节的二进制记录写入前先完成文件切换，返回 true 时需重新编码
+    bool rotateBeforeBinaryWrite(size_t size);
 
     // 成员变量
     std::mutex mutex;                      // 互斥锁
-    std::condition_variable cv;            // 条件变量
-    std::queue<std::string> logQueue;      // 日志缓存队列
-    std::atomic<bool> running;             // 控制写线程运行状态
-    std::thread writeThread;               // 日志写入线程
+    std::atomic<bool> running;             // 实例是否仍在运行
+    size_t writerIndex = 0;                // 所在的共享写线程
+    std::chrono::steady_clock::time_point lastTscResync; // 上次 TSC 对齐时间（仅写线程访问）
 
     fs::path logPath;                      // 日志文件路径
     std::string logName;                   // 日志文件名
     fs::path currentFilePath;              // 当前日志文件路径
+    uint64_t currentSegment = 1;           // 当前段序号
+    std::deque<fs::path> segmentFiles;     // 现存的段，按序号递增，含当前段（写线程或持有 mutex 时访问）
+    std::string periodTag;                 // 当前段的周期标记，按大小滚动时为空（写线程或持有 mutex 时访问）
     size_t maxFileSize;                    // 单个日志文件最大大小
     size_t maxFileCount;                   // 最大日志文件数量
-    std::ofstream outFile;                 // 文件输出流
+    std::unique_ptr<LogFileWriter> fileWriter; // 文件写入后端
+    std::atomic<int> pendingWriterMode{-1}; // 待切换的写入后端，-1 表示无
+    fs::path pendingLogPath;               // 待切换的日志目录，空表示不变（持有 mutex 时访问）
+    std::string pendingLogName;            // 待切换的日志名称，空表示不变（持有 mutex 时访问）
+    std::atomic<bool> logLocationPending{false};
+    mutable std::mutex writerStatsMutex;   // 保护后端切换与统计读取
+    LogWriterStats retiredWriterStats;     // 已替换后端的累计统计
+    std::vector<LogFileWriter*> retiringWriters; // 正在后台关闭的旧段，统计仍实时计入
+    FileWriterMode fileWriterMode = WRITEV_WRITER; // 当前后端类型（写线程或持有 mutex 时访问）
+
+    std::mutex nextSegmentMutex;           // 保护预开的下一段
+    std::condition_variable nextSegmentCV;
+    bool nextSegmentPreparing = false;     // 后台是否正在打开下一段
+    std::unique_ptr<LogFileWriter> nextWriter; // 预先打开的下一段
+    fs::path nextWriterPath;
+    uint64_t nextWriterSize = 0;           // 预开段打开时的长度
+
+    std::atomic<size_t> flushMaxBytes{LogFlushPolicy().maxBytes};     // 每批最大字节数
+    std::atomic<size_t> flushMaxRecords{LogFlushPolicy().maxRecords}; // 每批最大记录数
+    std::atomic<int64_t> flushMaxLatencyUs{LogFlushPolicy().maxLatency.count()}; // 每批最长等待时间（微秒）
+    std::atomic<bool> flushSync{false};    // 每批写出后落盘
+
+    std::atomic<int> durability{DURABILITY_NONE}; // 落盘策略
+    std::atomic<int64_t> durabilityIntervalUs{100000}; // 定期落盘间隔 / 等待落盘的超时（微秒）
+    std::atomic<bool> waitForCommit{false}; // log() 是否等待所在批次落盘
+    std::atomic<bool> syncRequested{false}; // flushToDisk 请求写线程立即落盘
+    std::atomic<int> durabilityWaiters{0};  // 正在等待落盘的生产者数
+    std::mutex durableMutex;                // 配合 durableCV 等待落盘
+    std::condition_variable durableCV;
+    bool unsynced = false;                  // 上次落盘后是否有新写入（仅写线程访问）
+    std::chrono::steady_clock::time_point lastSync; // 上次落盘时间（仅写线程访问）
+    std::vector<uint64_t> durableMarks;     // 落盘前记下的各缓冲区出队位置（仅写线程访问）
+    size_t pendingRecords = 0;             // 尚未提交的记录数（仅写线程访问）
+    std::chrono::steady_clock::time_point pendingSince; // 本批第一条记录的写入时间
 
     
-    std::atomic<size_t> logEntryCounter{0}; // 日志条数计数器
-    double checkThreshold = 0.9;           // 文件大小比例阈值
-    size_t lowCheckInterval = 20;          // 低频率检查间隔
-    size_t highCheckInterval = 5;          // 高频率检查间隔
-    size_t cachedFileSize = 0;             // 缓存的文件大小
+    uint64_t segmentBytes = 0;             // 当前段已写入的字节数，含未提交部分（仅写线程访问）
+    std::atomic<bool> rotateOnRecordBoundary{true}; // 是否按记录边界滚动
+    RotationPolicy rotationPolicy = ROTATE_BY_SIZE; // 滚动条件（持有 mutex 时访问）
+    RotationPeriod rotationPeriod = ROTATE_DAILY;   // 时间滚动周期（持有 mutex 时访问）
+    std::atomic<bool> rotateBySize{true};  // 是否按大小滚动
+    std::atomic<uint64_t> nextRotationNs{0}; // 下一个周期边界（纳秒），按大小滚动时为最大值，0 表示需要重新计算
 
-    std::bitset<5> logLevelEnabled = 0b11111; // 日志等级启用状态
+    std::atomic<uint32_t> levelMask{0x1F}; // 日志等级启用状态，第 level-1 位对应一个等级
+    LogCategoryTable categories{levelMask}; // 日志类别，顶层类别继承 levelMask
 
-    bool outputToConsole = false;          // 是否输出到终端
     bool compressLogs = false;             // 是否压缩日志
     bool jsonFormat = false;               // 是否使用 JSON 格式
 
-    // 远程日志配置
-    std::string remoteIp;                  // 远程服务器 IP
-    uint16_t remotePort = 0;               // 远程服务器端口
-    int sockfd = -1;                       // TCP 套接字
-    bool useSyslog = false;                // 是否使用 syslog
-    std::string syslogIdent;               // syslog 标识
-    int syslogFacility = LOG_USER;         // syslog 设施
-    int syslogLevel = LOG_DEBUG;           // syslog 级别
+    // 输出目标
+    std::mutex sinksMutex;                 // 保护 sinks 与内置 sink
+    std::vector<std::shared_ptr<LogSink>> sinks; // 已添加的 sink
+    std::atomic<bool> sinksChanged{false}; // sinks 有变化，写线程需更新快照
+    std::vector<std::shared_ptr<LogSink>> activeSinks; // 写线程使用的快照（仅写线程访问）
+    std::shared_ptr<LogSink> consoleSink;  // setOutputToConsole 创建的 sink
+    std::shared_ptr<LogSink> syslogSink;   // enableSyslog 创建的 sink
+    std::shared_ptr<LogSink> remoteSink;   // enableRemoteLogging 创建的 sink
 
 
 
@@ -181,19 +518,93 @@ private:
     size_t maxCompressedFileSize = 1* 1024; // 单个压缩文件最大大小
     std::vector<fs::path> compressedFiles; // 压缩文件路径列表
 
-    std::atomic<size_t> maxQueueSize{2000}; // 日志队列最大大小
-    std::atomic<bool> syslogInitialized{false}; // Syslog 是否已初始化
+    std::atomic<size_t> maxQueueSize{2000}; // 每线程缓冲区最大大小
+    std::atomic<int> overflowPolicy{DROP_OLDEST}; // 缓冲区满时的处理策略
+    std::atomic<int64_t> blockTimeoutUs{10000};   // BLOCK_WITH_TIMEOUT 的最长等待时间（微秒）
+    std::atomic<size_t> droppedCounts[5] = {}; // 按等级统计的丢弃条数
+    std::atomic<size_t> spilledCounts[5] = {}; // 按等级统计的溢出落盘条数
+    size_t reportedDrops[5] = {0};         // 上次汇总时的丢弃条数（仅写线程访问）
+    std::chrono::steady_clock::time_point lastDropReport; // 上次汇总时间
+    LogThrottle levelThrottles[5];         // 按等级的限流与采样配置
+    std::atomic<size_t> suppressedCounts[5] = {}; // 按等级统计的限流与采样丢弃条数
+    size_t reportedSuppressed[5] = {0};    // 上次汇总时的限流丢弃条数（仅写线程访问）
+    std::chrono::steady_clock::time_point lastSuppressReport; // 上次限流汇总时间
+
+    // 重复消息折叠状态（仅写线程访问）
+    struct RepeatState {
+        bool valid = false;                // 是否有可比较的上一条消息
+        uint64_t hash = 0;                 // 上一条消息的哈希
+        uint32_t callSiteId = 0;           // 上一条消息的调用点
+        LogLevel_en level = INFO;          // 上一条消息的等级
+        const char* file = nullptr;        // 上一条消息的源文件，未登记调用点时为空
+        int line = 0;                      // 上一条消息的行号
+        size_t repeats = 0;                // 尚未写出的重复次数
+        uint64_t lastTimestamp = 0;        // 最近一次重复的时间戳
+        std::chrono::steady_clock::time_point firstRepeat; // 本轮第一次重复的时间
+    };
+    std::atomic<bool> deduplicate{false};  // 是否折叠重复消息
+    std::atomic<int64_t> repeatFlushUs{1000000}; // 重复次数的最长滞留时间（微秒）
+    RepeatState repeatState;
+    std::mutex spillMutex;                 // 保护溢出文件
+    int spillFd = -1;                      // 溢出文件描述符
+
+    const uint64_t instanceId;             // 实例编号，用于区分线程局部缓冲区
+    std::mutex bufferListMutex;            // 保护线程缓冲区列表（仅注册与回收时加锁）
+    std::vector<std::shared_ptr<ThreadLogBuffer>> threadBuffers; // 所有生产线程的缓冲区
+    std::atomic<size_t> bufferListVersion{0}; // 缓冲区列表版本号
+    std::vector<std::shared_ptr<ThreadLogBuffer>> drainBuffersSnapshot; // 写线程持有的列表快照
+    size_t drainBuffersVersion = 0;        // 快照对应的版本号
     TimePrecision timePrecision = MILLISECONDS; // 时间戳精度
-
-    std::mutex compressMutex;              // 压缩任务队列互斥锁
-    std::condition_variable compressCV;    // 压缩任务条件变量
-    std::queue<std::function<void()>> compressQueue; // 压缩任务队列
-    std::thread compressThread;            // 压缩线程
-    std::atomic<bool> compressRunning{true}; // 压缩线程运行状态
-
-    std::queue<std::string> remoteQueue;   // 远程日志队列
-    std::thread remoteThread;              // 远程日志线程
-    std::atomic<bool> remoteRunning{true}; // 远程日志线程运行状态
+    std::atomic<int> timestampClock{SYSTEM_CLOCK}; // 时间戳时钟源
+    std::atomic<bool> deferredFormatting{false}; // 是否由写线程延迟格式化
+    std::string backendEntry;              // 写线程格式化用的可复用缓冲区
+    std::string backendMessage;            // 写线程格式化用的可复用缓冲区
+    std::atomic<bool> binaryFormat{false}; // 是否写入二进制格式
+    std::atomic<bool> binarySessionPending{false}; // 文件已切换，下一条二进制记录前需重新开始会话
+    BinaryLogEncoder binaryEncoder;        // 二进制编码器（仅写线程访问）
+    std::string backendBinary;             // 写线程编码用的可复用缓冲区
+
+    std::mutex backgroundMutex;            // 保护 backgroundPending
+    std::condition_variable backgroundCV;
+    size_t backgroundPending = 0;          // 已提交到后台任务线程、尚未完成的任务数
 };
 
+template <typename Fmt, typename... Args>
+void Logger::logf(LogLevel_en level, const char* file, int line, const Args&... args) {
+    static_assert(logFormatMatches<Args...>(Fmt::str()), "log format string does not match the argument types");
+
+    static const LogCallSite& site = LogCallSiteRegistry::instance().registerSite(file, line, nullptr, level, Fmt::str());
+    logf<Fmt>(site, args...);
+}
+
+template <typename Fmt, typename... Args>
+void Logger::logf(const LogCallSite& site, const Args&... args) {
+    static_assert(logFormatMatches<Args...>(Fmt::str()), "log format string does not match the argument types");
+
+    if (!isEnabled(site) || site.id == 0) return; // 如果该调用点未启用，直接返回
+
+    LogRecord record;
+    record.timestamp = timestampNowNs(static_cast<TimestampClock>(timestampClock.load(std::memory_order_relaxed)));
+    if (!admitRecord(site, record.timestamp)) return;
+    record.level = site.level;
+    record.callSiteId = site.id;
+    record.formatted = false;
+    std::string& payload = pendingPayload();
+    payload.clear();
+    packLogArgs<Fmt, 0>(payload, args...);
+    submitRecord(record, payload);
+}
+
+// 类型安全的日志宏：每个调用点生成独立的格式串类型，格式串与参数不匹配时编译失败
+#define LOGGER_LOGF(logger, level, fmt, ...)                                          \
+    do {                                                                              \
+        struct LogFormatString_ {                                                     \
+            static constexpr const char* str() { return fmt; }                        \
+        };                                                                            \
+        static const LogCallSite& logsysSite_ = LogCallSiteRegistry::instance().registerSite( \
+            __FILE__, __LINE__, __func__, level, LogFormatString_::str());            \
+        if ((logger).isEnabled(logsysSite_))                                          \
+            (logger).logf<LogFormatString_>(logsysSite_, ##__VA_ARGS__);             \
+    } while (0)
+
 #endif // LOGGER3_H
\ No newline at end of file
@@ -0,0 +1,436 @@
+// 日志系统性能测试工具
+// 用法: ./logsys-bench [timestamp|alloc|writer|pagecache|durability|rotation]
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <fcntl.h>
+#include <fstream>
+#include <algorithm>
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "Logger3.h"
+#include "LogBinaryFormat.h"
+#include "LogFileWriter.h"
+#include "LogTimestamp.h"
+#include "LogWorkerPool.h"
+
+// 统计当前线程的堆分配次数
+static thread_local size_t threadAllocations = 0;
+
+void* operator new(size_t size) {
+    ++threadAllocations;
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+namespace {
+
+// 旧版 Logger::getCurrentTimeString：每条记录 localtime + put_time + ostringstream
+std::string legacyTimeString(TimePrecision timePrecision) {
+    auto now = std::chrono::system_clock::now();
+    auto now_c = std::chrono::system_clock::to_time_t(now);
+    std::tm* local_time = std::localtime(&now_c);
+
+    std::ostringstream oss;
+    oss << std::put_time(local_time, "%Y-%m-%d %H:%M:%S");
+
+    auto duration = now.time_since_epoch();
+    auto sec = std::chrono::duration_cast<std::chrono::seconds>(duration);
+    duration -= sec;
+
+    switch (timePrecision) {
+        case SECONDS:
+            break;
+        case MILLISECONDS:
+            oss << "." << std::setw(3) << std::setfill('0')
+                << std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+            break;
+        case MICROSECONDS:
+            oss << "." << std::setw(6) << std::setfill('0')
+                << std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+            break;
+        case NANOSECONDS:
+            oss << "." << std::setw(9) << std::setfill('0')
+                << std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+            break;
+    }
+    return oss.str();
+}
+
+// 运行 iterations 次 fn，返回每次平均耗时（纳秒）
+template <typename Fn>
+double measure(size_t iterations, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) fn();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+volatile size_t sink; // 防止编译器优化掉结果
+
+void benchTimestamp() {
+    const size_t iterations = 1000000;
+    const char* names[] = {"SECONDS", "MILLISECONDS", "MICROSECONDS", "NANOSECONDS"};
+    bool tsc = TscClock::instance().available();
+
+    printf("%-14s %14s %14s %14s %14s\n", "precision", "legacy ns/op", "cached ns/op",
+           "cached+tsc", "clock only");
+    for (int p = SECONDS; p <= NANOSECONDS; ++p) {
+        TimePrecision precision = static_cast<TimePrecision>(p);
+        TimestampCache cache;
+        char buf[TimestampCache::kMaxLength];
+
+        double legacy = measure(iterations, [&] { sink = legacyTimeString(precision).size(); });
+        double cached = measure(iterations, [&] {
+            sink = cache.format(timestampNowNs(SYSTEM_CLOCK), precision, buf);
+        });
+        double cachedTsc = measure(iterations, [&] {
+            sink = cache.format(timestampNowNs(TSC_CLOCK), precision, buf);
+        });
+        double clockOnly = measure(iterations, [&] { sink = timestampNowNs(tsc ? TSC_CLOCK : SYSTEM_CLOCK); });
+        printf("%-14s %14.1f %14.1f %14.1f %14.1f\n", names[p], legacy, cached, cachedTsc, clockOnly);
+    }
+    printf("tsc clock: %s\n", tsc ? "available" : "unavailable (fell back to system clock)");
+}
+
+const size_t kAllocQueueSize = 4096;
+
+// 与日志实例挂在同一写线程上，stalled 期间阻塞整轮轮询，写线程不再排空队列
+class WriterStall : public LogPollable {
+public:
+    std::atomic<bool> stalled{false};
+
+    bool poll() override {
+        while (stalled.load()) usleep(100);
+        return false;
+    }
+};
+
+// 稳定状态下调用线程每条记录的堆分配次数，应为 0。记录池按需增长，预热时让写线程停下，
+// 一直写到出现第一次丢弃：此时队列已满且生产者还持有一条记录，池已增长到峰值用量
+template <typename Fn>
+double allocationsPerRecord(Logger& logger, WriterStall& stall, Fn logOnce) {
+    const int records = 200000;
+    size_t dropped = logger.getDroppedCount();
+    stall.stalled = true;
+    for (int i = 0; logger.getDroppedCount() == dropped; ++i) logOnce(i);
+    stall.stalled = false;
+    usleep(200 * 1000); // 等写线程排空
+
+    size_t before = threadAllocations;
+    for (int i = 0; i < records; ++i) logOnce(i);
+    return static_cast<double>(threadAllocations - before) / records;
+}
+
+// 返回 0 表示所有模式都没有产生分配
+int benchAlloc() {
+    LogWorkerPool& pool = LogWorkerPool::instance();
+    pool.setWriterThreads(1); // 日志实例与 WriterStall 共用一个写线程
+    Logger& logger = Logger::getInstance("/tmp/logsys-bench", "alloc", 1024 * 1024 * 1024, 2);
+    logger.setMaxQueueSize(kAllocQueueSize);
+    WriterStall stall;
+    size_t stallWriter = pool.attach(&stall);
+    int failures = 0;
+
+    auto report = [&failures](const char* mode, double perRecord) {
+        printf("%-22s %8.4f allocations/record\n", mode, perRecord);
+        if (perRecord > 0) ++failures;
+    };
+
+    report("eager log()", allocationsPerRecord(logger, stall, [&](int i) {
+        logger.log(INFO, "request %d finished in %.3f ms status=%s", __FILE__, __LINE__, i, i * 0.25, "ok");
+    }));
+
+    logger.setDeferredFormatting(true);
+    report("deferred log()", allocationsPerRecord(logger, stall, [&](int i) {
+        logger.log(INFO, "request %d finished in %.3f ms status=%s", __FILE__, __LINE__, i, i * 0.25, "ok");
+    }));
+    logger.setDeferredFormatting(false);
+
+    report("LOGGER_LOGF", allocationsPerRecord(logger, stall, [&](int i) {
+        LOGGER_LOGF(logger, INFO, "request %d finished in %.3f ms status=%s", i, i * 0.25, "ok");
+    }));
+
+    pool.detach(&stall, stallWriter);
+
+    LogPoolStats stats = logger.getRecordPoolStats();
+    printf("record pool: slab=%zuB allocated=%zu in-use=%zu large-in-use=%zu (%zuB) large-total=%zu\n",
+           stats.slabSize, stats.slabsAllocated, stats.slabsInUse, stats.largeRecordsInUse,
+           stats.largeBytesInUse, stats.largeRecordsTotal);
+    return failures == 0 ? 0 : 1;
+}
+
+// 等待写线程写出 target 条记录，超时返回 false
+bool waitForRecords(Logger& logger, uint64_t target) {
+    for (int i = 0; i < 10000; ++i) {
+        if (logger.getWriterStats().records >= target) return true;
+        usleep(1000);
+    }
+    return false;
+}
+
+// 不同写入后端与提交策略下的吞吐与系统调用次数
+int benchWriter() {
+    const int records = 200000;
+    Logger& logger = Logger::getInstance("/tmp/logsys-bench", "writer", 1024 * 1024 * 1024, 2);
+    logger.setMaxQueueSize(1 << 16);
+    logger.setOverflowPolicy(BLOCK_WITH_TIMEOUT, std::chrono::milliseconds(1000));
+
+    struct Mode {
+        const char* name;
+        LogFlushPolicy policy;
+        FileWriterMode writer = WRITEV_WRITER;
+    } modes[6];
+    modes[0].name = "per-record";
+    modes[0].policy.maxRecords = 1;
+    modes[1].name = "64KiB/256rec/1ms";
+    modes[1].policy.maxBytes = 64 * 1024;
+    modes[1].policy.maxRecords = 256;
+    modes[1].policy.maxLatency = std::chrono::microseconds(1000);
+    modes[2].name = "default";
+    modes[3].name = "mmap";
+    modes[3].writer = MMAP_WRITER;
+    modes[4].name = "io_uring";
+    modes[4].writer = IO_URING_WRITER;
+    modes[5].name = "io_uring+sync";
+    modes[5].writer = IO_URING_WRITER;
+    modes[5].policy.syncEachBatch = true;
+
+    printf("%-18s %12s %12s %12s %14s\n", "policy", "records/s", "batches", "rec/batch", "syscalls/rec");
+    for (const Mode& mode : modes) {
+        logger.setFlushPolicy(mode.policy);
+        logger.setFileWriterMode(mode.writer);
+        LogWriterStats before = logger.getWriterStats();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < records; ++i) {
+            logger.log(INFO, "request %d finished in %.3f ms status=%s", __FILE__, __LINE__, i, i * 0.25, "ok");
+        }
+        if (!waitForRecords(logger, before.records + records)) {
+            fprintf(stderr, "%s: timed out waiting for the writer\n", mode.name);
+            return 1;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        LogWriterStats after = logger.getWriterStats();
+        uint64_t batches = after.batches - before.batches;
+        printf("%-18s %12.0f %12llu %12.1f %14.4f\n", mode.name, records / seconds,
+               static_cast<unsigned long long>(batches), static_cast<double>(records) / batches,
+               static_cast<double>(after.writeCalls - before.writeCalls) / records);
+    }
+    return 0;
+}
+
+// 用 mincore 统计文件留在页缓存中的比例
+double residentRatio(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return -1;
+    struct stat st;
+    double ratio = -1;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t pages = (static_cast<size_t>(st.st_size) + pageSize - 1) / pageSize;
+        void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED) {
+            std::string resident(pages, '\0');
+            if (mincore(map, st.st_size, reinterpret_cast<unsigned char*>(&resident[0])) == 0) {
+                size_t count = 0;
+                for (char c : resident) count += c & 1;
+                ratio = static_cast<double>(count) / pages;
+            }
+            munmap(map, st.st_size);
+        }
+    }
+    close(fd);
+    return ratio;
+}
+
+// 各写入后端写完一个文件后该文件占用的页缓存
+int benchPageCache() {
+    const int records = 400000;
+    const char* dir = "/tmp/logsys-bench";
+    mkdir(dir, 0755);
+    struct Mode {
+        const char* name;
+        FileWriterMode writer;
+    } modes[] = {{"writev", WRITEV_WRITER}, {"direct", DIRECT_IO_WRITER}, {"dontneed", DONTNEED_WRITER}};
+
+    char line[160];
+    printf("%-10s %10s %12s %12s\n", "writer", "MiB", "records/s", "resident");
+    for (const Mode& mode : modes) {
+        std::string path = std::string(dir) + "/pagecache_" + mode.name + ".log";
+        unlink(path.c_str());
+        std::unique_ptr<LogFileWriter> writer = createLogFileWriter(mode.writer, 1024 * 1024 * 1024);
+        if (!writer->open(path)) {
+            fprintf(stderr, "%s: cannot open %s\n", mode.name, path.c_str());
+            return 1;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < records; ++i) {
+            int len = snprintf(line, sizeof(line),
+                               "[2024-01-01 00:00:00.000][INFO][bench.cpp:1] request %d finished in %.3f ms status=ok",
+                               i, i * 0.25);
+            writer->append(line, len, true);
+            if (i % 256 == 255) writer->flush();
+        }
+        writer->close();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        struct stat st;
+        stat(path.c_str(), &st);
+        printf("%-10s %10.1f %12.0f %11.1f%%\n", mode.name, st.st_size / 1048576.0, records / seconds,
+               residentRatio(path) * 100);
+    }
+    return 0;
+}
+
+// 各落盘策略下 log() 调用的延迟分布；等待落盘时即为提交延迟
+int benchDurability() {
+    const int threads = 4;
+    const int records = 2000; // 每线程
+    Logger& logger = Logger::getInstance("/tmp/logsys-bench", "durability", 1024 * 1024 * 1024, 2);
+    logger.setMaxQueueSize(1 << 16);
+    logger.setOverflowPolicy(BLOCK_WITH_TIMEOUT, std::chrono::milliseconds(1000));
+
+    struct Mode {
+        const char* name;
+        LogDurability durability;
+        bool wait;
+    } modes[] = {
+        {"none", DURABILITY_NONE, false},
+        {"periodic 10ms", DURABILITY_PERIODIC, false},
+        {"on-error", DURABILITY_ON_ERROR, false},
+        {"on-error+wait", DURABILITY_ON_ERROR, true},
+        {"group", DURABILITY_GROUP_COMMIT, false},
+        {"group+wait", DURABILITY_GROUP_COMMIT, true},
+    };
+
+    printf("%-15s %10s %9s %9s %9s %9s %9s %9s\n", "mode", "records/s", "syncs", "p50 us", "p90 us", "p99 us",
+           "p99.9 us", "max us");
+    for (const Mode& mode : modes) {
+        logger.setDurability(mode.durability, std::chrono::milliseconds(mode.durability == DURABILITY_PERIODIC ? 10 : 1000),
+                             mode.wait);
+        LogWriterStats before = logger.getWriterStats();
+        std::vector<std::vector<double>> latencies(threads);
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                std::vector<double>& out = latencies[t];
+                out.reserve(records);
+                for (int i = 0; i < records; ++i) {
+                    LogLevel_en level = i % 100 == 99 ? ERROR : INFO; // 1% 的 ERROR
+                    auto begin = std::chrono::steady_clock::now();
+                    logger.log(level, "request %d finished in %.3f ms status=%s", __FILE__, __LINE__, i, i * 0.25, "ok");
+                    out.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+                }
+            });
+        }
+        for (auto& worker : workers) worker.join();
+        if (!waitForRecords(logger, before.records + threads * records)) {
+            fprintf(stderr, "%s: timed out waiting for the writer\n", mode.name);
+            return 1;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::vector<double> all;
+        for (auto& part : latencies) all.insert(all.end(), part.begin(), part.end());
+        std::sort(all.begin(), all.end());
+        auto pct = [&all](double p) { return all[std::min(all.size() - 1, static_cast<size_t>(p * all.size()))]; };
+        LogWriterStats after = logger.getWriterStats();
+        printf("%-15s %10.0f %9llu %9.1f %9.1f %9.1f %9.1f %9.1f\n", mode.name, all.size() / seconds,
+               static_cast<unsigned long long>(after.syncCalls - before.syncCalls), pct(0.5), pct(0.9), pct(0.99),
+               pct(0.999), all.back());
+    }
+    logger.setDurability(DURABILITY_NONE);
+    return 0;
+}
+
+// 二进制格式下按大小滚动：每个段都应以会话头开始并能独立解码，各段记录数之和等于写入数
+int benchRotation() {
+    const int records = 2000;
+    const std::string dir = "/tmp/logsys-bench/rotation";
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+
+    Logger& logger = Logger::create("bench-rotation", dir, "rotation", 4096, 1000);
+    logger.setMaxQueueSize(1 << 16);
+    logger.setOverflowPolicy(BLOCK_WITH_TIMEOUT, std::chrono::milliseconds(1000));
+    logger.setBinaryFormat(true);
+    for (int i = 0; i < records; ++i) { // 前一半为已格式化文本记录，后一半为延迟格式化记录
+        if (i == records / 2) logger.setDeferredFormatting(true);
+        logger.log(INFO, "request %d finished in %.3f ms status=%s", __FILE__, __LINE__, i, i * 0.25, "ok");
+    }
+    bool drained = waitForRecords(logger, records);
+    Logger::destroy("bench-rotation");
+    if (!drained) {
+        fprintf(stderr, "rotation: timed out waiting for the writer\n");
+        return 1;
+    }
+
+    const char kSessionMarker[] = "\x7FLOGSYSB1";
+    size_t segments = 0;
+    size_t decoded = 0;
+    int failures = 0;
+    for (fs::directory_iterator it(dir), last; it != last; ++it) {
+        if (fs::is_symlink(it->symlink_status()) || it->path().extension() != ".log") continue;
+        std::ifstream in(it->path().string(), std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        ++segments;
+        if (data.compare(0, sizeof(kSessionMarker) - 1, kSessionMarker) != 0) {
+            fprintf(stderr, "%s: segment does not start with a session header\n", it->path().c_str());
+            ++failures;
+            continue;
+        }
+        BinaryLogDecoder decoder(data.data(), data.size());
+        DecodedLogRecord record;
+        while (decoder.next(record)) ++decoded;
+        if (!decoder.error().empty()) {
+            fprintf(stderr, "%s: %s\n", it->path().c_str(), decoder.error().c_str());
+            ++failures;
+        }
+    }
+    printf("segments=%zu records written=%d decoded=%zu\n", segments, records, decoded);
+    return failures == 0 && decoded == static_cast<size_t>(records) ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const char* which = argc > 1 ? argv[1] : "timestamp";
+    if (strcmp(which, "timestamp") == 0) {
+        benchTimestamp();
+    } else if (strcmp(which, "alloc") == 0) {
+        return benchAlloc();
+    } else if (strcmp(which, "writer") == 0) {
+        return benchWriter();
+    } else if (strcmp(which, "pagecache") == 0) {
+        return benchPageCache();
+    } else if (strcmp(which, "durability") == 0) {
+        return benchDurability();
+    } else if (strcmp(which, "rotation") == 0) {
+        return benchRotation();
+    } else {
+        fprintf(stderr, "usage: %s [timestamp|alloc|writer|pagecache|durability|rotation]\n", argv[0]);
+        return 1;
+    }
+    return 0;
+}
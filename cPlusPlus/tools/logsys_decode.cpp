@@ -0,0 +1,106 @@
+// 二进制日志解码工具：把 setBinaryFormat(true) 写出的日志还原为文本或 JSON
+// 用法: ./logsys-decode [--json] [--precision s|ms|us|ns] <file>...
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include "LogBinaryFormat.h"
+#include "LogLayout.h"
+#include "LogTimestamp.h"
+
+namespace {
+
+const char kSessionMarker[] = "\x7FLOGSYSB1";
+
+void usage() {
+    std::cerr << "usage: logsys-decode [--json] [--precision s|ms|us|ns] <file>..." << std::endl;
+}
+
+bool parsePrecision(const char* name, TimePrecision& precision) {
+    if (strcmp(name, "s") == 0) precision = SECONDS;
+    else if (strcmp(name, "ms") == 0) precision = MILLISECONDS;
+    else if (strcmp(name, "us") == 0) precision = MICROSECONDS;
+    else if (strcmp(name, "ns") == 0) precision = NANOSECONDS;
+    else return false;
+    return true;
+}
+
+// 解码一个文件并输出到 stdout，返回是否完整解码
+bool decodeFile(const char* path, bool json, bool overridePrecision, TimePrecision precision) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << path << ": cannot open file" << std::endl;
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    // 开启二进制格式前写入的文本行原样跳过
+    size_t start = data.find(kSessionMarker, 0, sizeof(kSessionMarker) - 1);
+    if (start == std::string::npos) {
+        std::cerr << path << ": no binary log session found" << std::endl;
+        return false;
+    }
+    if (start > 0) {
+        std::cerr << path << ": skipped " << start << " bytes of non-binary data" << std::endl;
+    }
+
+    BinaryLogDecoder decoder(data.data() + start, data.size() - start);
+    DecodedLogRecord record;
+    TimestampCache timestamps;
+    char timestamp[TimestampCache::kMaxLength];
+    std::string line;
+    size_t count = 0;
+    while (decoder.next(record)) {
+        line.clear();
+        if (record.preformatted) {
+            line = record.message;
+        } else {
+            size_t timestampLen = timestamps.format(record.timestamp,
+                                                    overridePrecision ? precision : decoder.precision(), timestamp);
+            appendLogEntry(line, json, timestamp, timestampLen, record.level, record.file, record.line,
+                           record.message.data(), record.message.size());
+        }
+        line.push_back('\n');
+        fwrite(line.data(), 1, line.size(), stdout);
+        ++count;
+    }
+
+    if (!decoder.error().empty()) {
+        std::cerr << path << ": " << decoder.error() << " after " << count << " records" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    bool json = false;
+    bool overridePrecision = false;
+    TimePrecision precision = MILLISECONDS;
+    int first = 1;
+    for (; first < argc && argv[first][0] == '-'; ++first) {
+        if (strcmp(argv[first], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[first], "--precision") == 0 && first + 1 < argc &&
+                   parsePrecision(argv[first + 1], precision)) {
+            overridePrecision = true;
+            ++first;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (first >= argc) {
+        usage();
+        return 2;
+    }
+
+    bool ok = true;
+    for (int i = first; i < argc; ++i) {
+        ok = decodeFile(argv[i], json, overridePrecision, precision) && ok;
+    }
+    return ok ? 0 : 1;
+}